@@ -5,6 +5,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,11 +21,113 @@ typedef const struct enum_desc_ext *enum_desc_ext_t ;
 const char *enum_desc_name(enum_desc_t ed) ;
 int enum_desc_value_count(enum_desc_t ed);
 enum_desc_idx enum_desc_find_by_label(enum_desc_t ed, const char *label) ;
+enum_desc_idx enum_desc_find_by_label_n(enum_desc_t ed, const char *label, size_t len) ;
+// Label pointer from enum_desc_label_at back to its index, by offset into the label blob.
+// Other pointers fall back to enum_desc_find_by_label.
+enum_desc_idx enum_desc_index_of_label_ptr(enum_desc_t ed, const char *label) ;
 enum_desc_idx enum_desc_find_by_value(enum_desc_t ed, enum_desc_val value) ;
 const char * enum_desc_label_at(enum_desc_t ed, enum_desc_idx idx) ;
 enum_desc_val enum_desc_value_at(enum_desc_t ed, enum_desc_idx idx) ;
 void * enum_desc_meta_at(enum_desc_t ed, enum_desc_idx idx) ;
 
+// Indexes of all items with this value, in declaration order. Returns the total count,
+// stores at most max. The first one is the index returned by enum_desc_find_by_value.
+int enum_desc_aliases_of(enum_desc_t ed, enum_desc_val value, enum_desc_idx *idx_out, int max) ;
+
+// Copy label into buf, NUL terminated and truncated to size. Returns the label length, -1 for a bad index.
+// Does not materialize labels of trie-only descriptors.
+int enum_desc_label_copy(enum_desc_t ed, enum_desc_idx idx, char *buf, size_t size) ;
+
+// Extra label sets (display names, wire names...), numbered 1 to enum_desc_label_set_count.
+// Set 0 is the primary labels: enum_desc_label_at_set(ed, 0, idx) == enum_desc_label_at(ed, idx).
+int enum_desc_label_set_count(enum_desc_t ed) ;
+// Set name, NULL for set 0 and unknown sets.
+const char *enum_desc_label_set_name(enum_desc_t ed, int set) ;
+// Set number by name, -1 if none.
+int enum_desc_label_set_find(enum_desc_t ed, const char *set_name) ;
+const char *enum_desc_label_at_set(enum_desc_t ed, int set, enum_desc_idx idx) ;
+// First index (declaration order) with this label in the set.
+enum_desc_idx enum_desc_find_by_label_set(enum_desc_t ed, int set, const char *label) ;
+
+// Typed per-item columns (weights, rates...), numbered from 0, stored contiguously in declaration order.
+int enum_desc_column_count(enum_desc_t ed) ;
+// Column number by name, -1 if none.
+int enum_desc_column_find(enum_desc_t ed, const char *name) ;
+// Start of the column, *size_out gets the bytes per item. NULL for unknown columns.
+const void *enum_desc_column_data(enum_desc_t ed, int col, size_t *size_out) ;
+// Item of a column, NULL for a bad column or index.
+const void *enum_desc_column_at(enum_desc_t ed, int col, enum_desc_idx idx) ;
+
+// Sorted iteration, no allocation. Equal values or labels come in declaration order.
+enum enum_desc_order {
+	ENUM_DESC_ORDER_DECL,				// declaration order
+	ENUM_DESC_ORDER_VALUE,				// by value
+	ENUM_DESC_ORDER_LABEL,				// by label (strcmp)
+} ;
+
+struct enum_desc_iter {
+	enum_desc_t ed ;
+	enum enum_desc_order order ;
+	int pos ;							// next position in the order
+	enum_desc_idx cur ;					// last index returned, -1 before the first
+} ;
+
+void enum_desc_iter_sorted(enum_desc_t ed, enum enum_desc_order order, struct enum_desc_iter *it) ;
+// Next index, ENUM_DESC_NOT_FOUND at the end.
+enum_desc_idx enum_desc_iter_next(struct enum_desc_iter *it) ;
+// Indexes of the items with lo <= value <= hi, in value order. Returns the total count,
+// stores at most max.
+int enum_desc_range(enum_desc_t ed, enum_desc_val lo, enum_desc_val hi, enum_desc_idx *idx_out, int max) ;
+
+bool enum_desc_is_valid(enum_desc_t ed, enum_desc_val value) ;
+// true if all values are valid, else *bad_idx_out gets the first invalid position.
+bool enum_desc_validate(enum_desc_t ed, const enum_desc_val *vals, size_t n, size_t *bad_idx_out) ;
+
+// Resumable label matcher, for labels arriving in pieces (one byte at a time is fine).
+// Keeps no copy of the input. Uses the label trie when the descriptor has one.
+enum enum_desc_match_state {
+	ENUM_DESC_MATCH_NEED_MORE,			// prefix of some label, not a label itself
+	ENUM_DESC_MATCH_PREFIX,				// a label, and also a prefix of longer labels
+	ENUM_DESC_MATCH_FULL,				// a label, any further byte rejects
+	ENUM_DESC_MATCH_REJECT,				// not a prefix of any label
+} ;
+
+struct enum_desc_matcher {
+	enum_desc_t ed ;
+	enum enum_desc_match_state state ;
+	size_t len ;						// bytes matched so far
+	int node ;							// trie: node the last byte led to
+	int edge_pos ;						// trie: bytes matched on the edge into node
+	enum_desc_idx cand ;				// no trie: first label starting with the bytes fed
+	enum_desc_idx term ;				// label equal to the bytes fed, -1 if none
+} ;
+
+void enum_desc_matcher_init(struct enum_desc_matcher *m, enum_desc_t ed) ;
+// Feed the next len bytes, stops early on reject.
+enum enum_desc_match_state enum_desc_matcher_feed(struct enum_desc_matcher *m, const char *buf, size_t len) ;
+// End of token: index of the label fed, ENUM_DESC_NOT_FOUND if none.
+enum_desc_idx enum_desc_matcher_finish(const struct enum_desc_matcher *m) ;
+
+// Content fingerprint: FNV-1a 64 over the name and NUL, then per item in declaration
+// order the label and NUL and the value as 4 bytes little endian; 0 maps to 1.
+// Same for plugin, enum_refl_build and enum_desc_tablegen descriptors, read from the
+// header when stored, else computed. Equal fingerprints: same name, labels, values
+// and order, so indexes (sets, packed columns) mean the same on both sides.
+uint64_t enum_desc_fingerprint(enum_desc_t ed) ;
+
+// What differs between two versions of an enum, labels matched by name.
+struct enum_desc_diff {
+	bool name ;							// names differ
+	int only_a ;						// labels of a missing from b
+	int only_b ;						// labels of b missing from a
+	int value_changed ;					// label in both, different value
+	int moved ;							// label in both with the same value, different index
+} ;
+
+// Returns the number of differences (0 when the fingerprints match, without
+// looking at the items). out may be NULL.
+int enum_desc_diff(enum_desc_t a, enum_desc_t b, struct enum_desc_diff *out) ;
+
 void enum_desc_destroy(enum_desc_t ed) ;
 extern const struct enum_desc_ext enum_desc_default_ext ;
 
@@ -36,6 +139,8 @@ extern const struct enum_desc_ext enum_desc_default_ext ;
 #include <stdbool.h>
 #include <stdio.h>
 void enum_desc_print(FILE *fp, enum_desc_t ed, bool verbose) ;
+// One line per difference: "-LABEL", "+LABEL", "~LABEL a -> b" (value), ">LABEL #i -> #j" (index).
+void enum_desc_diff_print(FILE *fp, enum_desc_t a, enum_desc_t b) ;
 #endif
 
 extern const enum_desc_t enum_desc_null ;
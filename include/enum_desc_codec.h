@@ -0,0 +1,40 @@
+#ifndef _ENUM_DESC_CODEC_H_
+#define _ENUM_DESC_CODEC_H_
+
+#include "enum_desc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bit packed enum columns. Each value is stored as its descriptor index (the one
+// enum_desc_find_by_value returns) in enum_desc_codec_bits bits, little endian,
+// item i at bit i * bits. Code value_count marks a value without a label, it
+// decodes to default_value. Read-only after create, can be shared between threads.
+typedef const struct enum_desc_codec *enum_desc_codec_t ;
+
+// Items per block: a block always fills whole bytes, so columns can be written and
+// read in chunks of any multiple of it.
+#define ENUM_DESC_CODEC_BLOCK 64
+
+// ed must have at least one item and outlive the codec.
+enum_desc_codec_t enum_desc_codec_create(enum_desc_t ed, enum_desc_val default_value) ;
+void enum_desc_codec_destroy(enum_desc_codec_t c) ;
+
+// Bits per item: enough for value_count + 1 codes.
+int enum_desc_codec_bits(enum_desc_codec_t c) ;
+// Bytes holding n items.
+size_t enum_desc_codec_size(enum_desc_codec_t c, size_t n) ;
+
+// Pack n values into out[enum_desc_codec_size(c, n)]. Returns the number of values
+// without a label.
+size_t enum_desc_codec_encode(enum_desc_codec_t c, const enum_desc_val *vals, size_t n, void *out) ;
+// Unpack items first .. first+n-1 of a column of size bytes. Returns the number of
+// items decoded as default_value, or (size_t) -1 when the range is past the end.
+size_t enum_desc_codec_decode(enum_desc_codec_t c, const void *in, size_t size, size_t first, size_t n, enum_desc_val *vals) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef _ENUM_DESC_COUNTER_H_
+#define _ENUM_DESC_COUNTER_H_
+
+#include "enum_desc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-item value counters. Each thread that counts gets its own cache line aligned
+// array, so increments never share a line with another writer. Snapshots add up
+// the per-thread arrays and may run while writers are counting.
+typedef struct enum_desc_counter *enum_desc_counter_t ;
+
+enum_desc_counter_t enum_desc_counter_create(enum_desc_t ed) ;
+// No thread may count on c any more.
+void enum_desc_counter_destroy(enum_desc_counter_t c) ;
+
+// Counted at the index enum_desc_find_by_value returns (the first label of an
+// aliased value). Values without a label go to the overflow bucket.
+void enum_desc_counter_add(enum_desc_counter_t c, enum_desc_val value, uint64_t n) ;
+static inline void enum_desc_counter_inc(enum_desc_counter_t c, enum_desc_val value)
+{
+	enum_desc_counter_add(c, value, 1) ;
+}
+
+// counts[value_count + 1]: per index in declaration order, then the overflow bucket.
+// Each count is exact for some moment during the call, the total is not atomic.
+void enum_desc_counter_snapshot(enum_desc_counter_t c, uint64_t *counts) ;
+// Labels with a count, and the overflow bucket when not 0.
+void enum_desc_counter_print(FILE *fp, enum_desc_counter_t c) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
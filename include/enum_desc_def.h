@@ -3,22 +3,92 @@
 
 #include "enum_desc.h"
 
-#ifdef _cplusplus
+#ifdef __cplusplus
 extern "C" {
 #endif
 
 /// @brief Enum description structure
+/// The first 64 bytes hold what value lookups and label_at read, the rest is for label
+/// lookups, enum_refl_* and less used features.
 struct enum_desc {
 //	const char *name ;                  // Name is stored at the start of lbl_str blob, no need to duplicate it here.
 	uint16_t value_count ;              // Number of items in the enum, also size of values[] and lbl_off[]
 	uint16_t flags ;			        // bitfield of flags, for internal use. 
+	uint16_t uniq_count ;				// Number of distinct values, size of by_value[]
+	uint16_t label_set_count ;			// Number of extra label sets, size of label_sets[]
 	const enum_desc_val *values ;		// Array of enum values, in declaration order.
-	const uint16_t *lbl_off ;			// Array of offsets into strs for each label, in declaration order.
+	const uint16_t *lbl_off ;			// Array of offsets into strs for each label, in declaration order (ascending).
+	const char *strs ;                  // null separated list of name, labels + 8 nul padding.
+	enum_desc_val value_min ;			// Smallest value, valid when ENUM_DESC_F_RANGE is set.
+	enum_desc_val value_max ;			// Largest value, valid when ENUM_DESC_F_RANGE is set.
+	const uint32_t *value_bits ;		// Optional bitmap over [value_min, value_max]. NULL for wide ranges.
+	const uint16_t *value_rank ;		// Optional, per value_bits word: number of set bits in earlier words.
+	const enum_desc_idx *by_value ;		// Optional, first index of each distinct value, sorted by value.
+	const enum_desc_idx *alias_next ;	// Optional, next index with the same value, -1 at end. NULL if values are unique.
+	const enum_desc_idx *lbl_blk ;		// Optional, per 8 bytes of strs up to the last label: first label starting in or after it.
+	const struct enum_desc_trie *trie ;	// Optional label trie, for O(label length) lookups.
 	void **meta ;						// Optional array of per-item metadata, in declaration order. NULL if not used.
 	enum_desc_ext_t ext ;				// Optional pointer to extension struct, for dynamic descs or extra features. NULL if not used.
-	const char *strs ;                  // null separated list of name, labels + 8 nul padding.
+	uint32_t generation ;				// Built descriptors: distinct per build, keys the lookup cache. 0 for static ones.
+	void **lbl_cache ;					// Writable slot for labels materialized from the trie (ENUM_DESC_F_TRIE_LABELS).
+	const struct enum_desc_label_set *label_sets ;	// Optional extra labels per item (wire names, display names).
+	const struct enum_desc_meta *meta_info ;	// Optional sparse meta index and typed columns.
+	const enum_desc_idx *by_label ;		// Optional, every index sorted by label (strcmp), equal labels in declaration order.
+	uint64_t fingerprint ;				// Content hash (see enum_desc_fingerprint), 0 when not stored.
+} ;
+
+/// @brief Extra label set, numbered from 1 in the API (0 is the primary labels).
+/// Same layout as the primary labels: strs starts with the set name.
+struct enum_desc_label_set {
+	const char *strs ;					// set name, labels + 8 nul padding
+	const uint16_t *lbl_off ;			// [value_count] offsets into strs, in declaration order
+	const struct enum_desc_trie *trie ;	// Optional, from ENUM_DESC_TRIE_MIN_COUNT items, edges point into strs
+} ;
+
+/// @brief Sparse meta and typed per-item columns.
+/// With bits set, meta[] holds only the items that have metadata, in declaration order:
+/// item idx is meta[rank[idx/32] + bits set below idx in bits[idx/32]].
+struct enum_desc_meta {
+	const uint32_t *bits ;				// Optional presence bitmap over indexes, NULL when meta[] is dense
+	const uint16_t *rank ;				// per bits word: present items in earlier words
+	uint16_t column_count ;
+	const struct enum_desc_column *columns ;
+} ;
+
+struct enum_desc_column {
+	const char *name ;
+	uint32_t size ;						// bytes per item
+	const void *data ;					// [value_count * size], in declaration order
+} ;
+
+/// @brief Radix trie over the labels. Nodes are numbered breadth first, node 0 is the root,
+/// children of node n are child[n] .. child[n+1]-1, sorted by the first byte of their edge.
+struct enum_desc_trie {
+	uint16_t node_count ;
+	const uint32_t *seg_off ;			// [node] offset into segs of the edge bytes leading to the node
+	const uint16_t *seg_len ;			// [node] edge length, 0 for the root
+	const uint16_t *parent ;			// [node]
+	const uint16_t *child ;				// [node_count+1] first child
+	const enum_desc_idx *term ;			// [node] first label (declaration order) ending at the node, -1 if none
+	const uint16_t *leaf ;				// [value_count] node where each label ends
+	const char *segs ;					// edge bytes: strs, or a separate blob when labels are stored only in the trie
 } ;
 
+// flags
+#define ENUM_DESC_F_DYNAMIC (1<<0)		// Built by enum_refl_build, free by enum_desc_destroy
+#define ENUM_DESC_F_RANGE (1<<1)		// value_min/value_max are set
+#define ENUM_DESC_F_TRIE_LABELS (1<<2)	// Labels are only in the trie, strs has just the name, lbl_off is NULL
+#define ENUM_DESC_F_ARENA (1<<3)		// Built by enum_refl_build_in, freed by enum_desc_arena_release only
+#define ENUM_DESC_F_INTERNED (1<<4)		// Built by enum_refl_build_interned, enum_desc_destroy drops a reference
+
+// value_bits is only built when it fits in this many 32 bit words.
+#define ENUM_DESC_BITMAP_WORDS_MAX(count) ((count) + 64)
+
+// Label trie is built from this many items.
+#define ENUM_DESC_TRIE_MIN_COUNT 8
+// Labels are stored only in the trie (ENUM_DESC_F_TRIE_LABELS) from this many label bytes.
+#define ENUM_DESC_TRIE_LABELS_MIN_BYTES 4096
+
 /// @brief 
 struct enum_desc_ext {
 	void *enum_cxt ;                                                        // private data, free by destroy
@@ -35,7 +105,16 @@ struct enum_desc_ext {
 /// Usage: enum_desc_t my_enum_desc = ENUM_DESC(enum my_enum)
 #define ENUM_DESC(T) (enum_desc_gen((T)0))
 
-#ifdef _cplusplus
+/// @brief Enums declared with ENUM_REFLECT get a public descriptor, no wrapper needed.
+/// ENUM_DESC_REF is its address, a link-time constant usable in static initializers.
+/// E is the symbol suffix: the tag in C, the qualified name with "::" as "__" in C++.
+/// Usage: enum ENUM_REFLECT color { ... } ;  ENUM_DESC_EXTERN(color) ;
+///        static const enum_desc_t tbl[] = { ENUM_DESC_REF(color) } ;
+#define ENUM_REFLECT __attribute__((enum_reflect))
+#define ENUM_DESC_EXTERN(E) extern const struct enum_desc __enum_desc__##E
+#define ENUM_DESC_REF(E) (&__enum_desc__##E)
+
+#ifdef __cplusplus
 }
 #endif
 
@@ -0,0 +1,34 @@
+#ifndef _ENUM_DESC_INDEX_H_
+#define _ENUM_DESC_INDEX_H_
+
+#include "enum_desc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Label index over many descriptors: label -> all (descriptor, index) pairs.
+// Read-only after build, can be shared between threads.
+typedef const struct enum_desc_index *enum_desc_index_t ;
+
+struct enum_desc_match {
+	enum_desc_t ed ;
+	enum_desc_idx idx ;
+} ;
+
+enum_desc_index_t enum_desc_index_build(const enum_desc_t eds[], int count) ;
+// Index over every plugin-emitted descriptor linked into the program.
+enum_desc_index_t enum_desc_index_build_registry(void) ;
+void enum_desc_index_destroy(enum_desc_index_t index) ;
+
+// Number of matches, *matches gets them in build order (NULL if none).
+int enum_desc_index_lookup(enum_desc_index_t index, const char *label, size_t len, const struct enum_desc_match **matches) ;
+
+// Plugin-emitted descriptors, one entry per translation unit that reflects the enum.
+const enum_desc_t *enum_desc_registry(int *count) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
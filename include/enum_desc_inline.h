@@ -0,0 +1,138 @@
+#ifndef _ENUM_DESC_INLINE_H_
+#define _ENUM_DESC_INLINE_H_
+
+// Inline versions of the enum_desc accessors and lookup kernels, for callers that
+// see the struct layout. Same results as the out-of-line functions in enum_desc.h,
+// which stay the ABI for code treating enum_desc_t as opaque. The library uses
+// these kernels itself.
+//
+// With ENUM_DESC_USE_INLINE defined before the include, the enum_desc_* names map
+// to the inline versions.
+
+#include "enum_desc_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline const char *enum_desc_inline_name(enum_desc_t ed)
+{
+	return ed->strs ;
+}
+
+static inline int enum_desc_inline_value_count(enum_desc_t ed)
+{
+	return ed->value_count ;
+}
+
+static inline bool enum_desc_inline_valid_index(enum_desc_t ed, enum_desc_idx idx)
+{
+	return idx >= 0 && idx < ed->value_count ;
+}
+
+static inline enum_desc_val enum_desc_inline_value_at(enum_desc_t ed, enum_desc_idx idx)
+{
+	return enum_desc_inline_valid_index(ed, idx) ? ed->values[idx] : 0 ;
+}
+
+// Trie-only descriptors materialize their labels out of line.
+static inline const char *enum_desc_inline_label_at(enum_desc_t ed, enum_desc_idx idx)
+{
+	if ( !enum_desc_inline_valid_index(ed, idx) ) return NULL ;
+	if ( ed->flags & ENUM_DESC_F_TRIE_LABELS ) return enum_desc_label_at(ed, idx) ;
+	return ed->strs + ed->lbl_off[idx] ;
+}
+
+// Sparse meta: presence bit, then rank into the packed array.
+static inline void *enum_desc_inline_meta_at(enum_desc_t ed, enum_desc_idx idx)
+{
+	if ( !enum_desc_inline_valid_index(ed, idx) || !ed->meta ) return NULL ;
+	const struct enum_desc_meta *mi = ed->meta_info ;
+	if ( !mi || !mi->bits ) return ed->meta[idx] ;
+	uint32_t word = mi->bits[idx >> 5], bit = 1u << (idx & 31) ;
+	return word & bit ? ed->meta[mi->rank[idx >> 5] + __builtin_popcount(word & (bit - 1))] : NULL ;
+}
+
+static inline const void *enum_desc_inline_column_at(enum_desc_t ed, int col, enum_desc_idx idx)
+{
+	const struct enum_desc_meta *mi = ed->meta_info ;
+	if ( !enum_desc_inline_valid_index(ed, idx) || !mi || col < 0 || col >= mi->column_count ) return NULL ;
+	return (const char *) mi->columns[col].data + (size_t) idx * mi->columns[col].size ;
+}
+
+static inline enum_desc_idx enum_desc_inline_scan_by_value(enum_desc_t ed, enum_desc_val value)
+{
+	for (int i=0 ; i<ed->value_count ; i++) {
+		if ( ed->values[i] == value ) return i ;
+	}
+	return ENUM_DESC_NOT_FOUND ;
+}
+
+// Binary search over the distinct values.
+static inline enum_desc_idx enum_desc_inline_search_by_value(enum_desc_t ed, enum_desc_val value)
+{
+	int lo = 0, hi = ed->uniq_count ;
+	while ( lo < hi ) {
+		int mid = (lo + hi) / 2 ;
+		enum_desc_val v = ed->values[ed->by_value[mid]] ;
+		if ( v == value ) return ed->by_value[mid] ;
+		if ( v < value ) lo = mid + 1 ; else hi = mid ;
+	}
+	return ENUM_DESC_NOT_FOUND ;
+}
+
+// Fastest route available: bitmap rank (O(1)), sorted distinct values, linear scan.
+// With aliases, always the first index in declaration order.
+static inline enum_desc_idx enum_desc_inline_find_by_value(enum_desc_t ed, enum_desc_val value)
+{
+	if ( !ed->by_value ) return enum_desc_inline_scan_by_value(ed, value) ;
+	if ( (ed->flags & ENUM_DESC_F_RANGE) ) {
+		uint32_t off = (uint32_t) value - (uint32_t) ed->value_min ;
+		if ( off > (uint32_t) ed->value_max - (uint32_t) ed->value_min ) return ENUM_DESC_NOT_FOUND ;
+		if ( ed->value_bits && ed->value_rank ) {
+			uint32_t word = ed->value_bits[off >> 5], bit = 1u << (off & 31) ;
+			if ( !(word & bit) ) return ENUM_DESC_NOT_FOUND ;
+			return ed->by_value[ed->value_rank[off >> 5] + __builtin_popcount(word & (bit - 1))] ;
+		}
+	}
+	return enum_desc_inline_search_by_value(ed, value) ;
+}
+
+// Range check, then bitmap. Wide ranges have no bitmap and fall back to the value index.
+static inline bool enum_desc_inline_is_valid(enum_desc_t ed, enum_desc_val value)
+{
+	if ( !(ed->flags & ENUM_DESC_F_RANGE) ) return enum_desc_inline_find_by_value(ed, value) != ENUM_DESC_NOT_FOUND ;
+	uint32_t off = (uint32_t) value - (uint32_t) ed->value_min ;
+	if ( off > (uint32_t) ed->value_max - (uint32_t) ed->value_min ) return false ;
+	if ( !ed->value_bits ) return enum_desc_inline_find_by_value(ed, value) != ENUM_DESC_NOT_FOUND ;
+	return (ed->value_bits[off >> 5] >> (off & 31)) & 1 ;
+}
+
+// Labels with a trie go out of line, the scan stays inline.
+static inline enum_desc_idx enum_desc_inline_find_by_label(enum_desc_t ed, const char *label)
+{
+	if ( ed->trie ) return enum_desc_find_by_label(ed, label) ;
+	// strcmp stops at the shorter string, memcmp could read past the last label
+	for (int i=0 ; i<ed->value_count ; i++) {
+		if ( !strcmp(ed->strs + ed->lbl_off[i], label) ) return i ;
+	}
+	return ENUM_DESC_NOT_FOUND ;
+}
+
+#ifdef ENUM_DESC_USE_INLINE
+#define enum_desc_name(ed) enum_desc_inline_name(ed)
+#define enum_desc_value_count(ed) enum_desc_inline_value_count(ed)
+#define enum_desc_value_at(ed, idx) enum_desc_inline_value_at(ed, idx)
+#define enum_desc_label_at(ed, idx) enum_desc_inline_label_at(ed, idx)
+#define enum_desc_meta_at(ed, idx) enum_desc_inline_meta_at(ed, idx)
+#define enum_desc_column_at(ed, col, idx) enum_desc_inline_column_at(ed, col, idx)
+#define enum_desc_find_by_value(ed, value) enum_desc_inline_find_by_value(ed, value)
+#define enum_desc_is_valid(ed, value) enum_desc_inline_is_valid(ed, value)
+#define enum_desc_find_by_label(ed, label) enum_desc_inline_find_by_label(ed, label)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _ENUM_DESC_REMAP_H_
+#define _ENUM_DESC_REMAP_H_
+
+#include "enum_desc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Value translation between two versions of an enum, keyed by label.
+// Read-only after build, can be shared between threads.
+typedef const struct enum_desc_remap *enum_desc_remap_t ;
+
+#define ENUM_DESC_REMAP_DEFAULT (1<<0)	// dropped and unknown values become default_value, else unchanged
+#define ENUM_DESC_REMAP_BY_VALUE (1<<1)	// a dropped label whose value has a label in the new enum is a rename
+
+struct enum_desc_remap_policy {
+	unsigned flags ;					// ENUM_DESC_REMAP_*
+	enum_desc_val default_value ;
+	const char *const *renames ;		// optional old, new label pairs, NULL terminated
+} ;
+
+struct enum_desc_remap_pair {
+	enum_desc_idx old_idx ;
+	enum_desc_idx new_idx ;
+} ;
+
+// Differences found at build time, indexes are in declaration order.
+struct enum_desc_remap_report {
+	int mapped ;						// labels found in both
+	int renamed_count ;
+	const struct enum_desc_remap_pair *renamed ;
+	int dropped_count ;
+	const enum_desc_idx *dropped ;		// old indexes without a new value
+	int added_count ;
+	const enum_desc_idx *added ;		// new indexes nothing maps to
+	bool dense ;						// table indexed by value, else sorted by value
+} ;
+
+// policy may be NULL: keep unknown values, no renames. Both descriptors must outlive
+// the map when enum_desc_remap_print is used.
+enum_desc_remap_t enum_desc_remap_build(enum_desc_t old_ed, enum_desc_t new_ed, const struct enum_desc_remap_policy *policy) ;
+void enum_desc_remap_destroy(enum_desc_remap_t map) ;
+const struct enum_desc_remap_report *enum_desc_remap_report(enum_desc_remap_t map) ;
+void enum_desc_remap_print(FILE *fp, enum_desc_remap_t map) ;
+
+// Translate vals in place. Returns the number of values that were unknown or dropped.
+size_t enum_desc_remap_apply(enum_desc_remap_t map, enum_desc_val *vals, size_t n) ;
+enum_desc_val enum_desc_remap_value(enum_desc_remap_t map, enum_desc_val value) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef _ENUM_DESC_SET_H_
+#define _ENUM_DESC_SET_H_
+
+#include "enum_desc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Set of items of one enum, one bit per index in declaration order. Values go
+// through enum_desc_find_by_value; an aliased value is one member, stored at its
+// first index, and labels parsed from text set the bit of that label's index.
+// Set operations need both sets on the same descriptor and work a 256 bit block
+// at a time.
+typedef struct enum_desc_set *enum_desc_set_t ;
+
+enum_desc_set_t enum_desc_set_create(enum_desc_t ed) ;
+void enum_desc_set_destroy(enum_desc_set_t s) ;
+enum_desc_t enum_desc_set_desc(enum_desc_set_t s) ;
+
+void enum_desc_set_clear(enum_desc_set_t s) ;
+// Every item.
+void enum_desc_set_fill(enum_desc_set_t s) ;
+
+// false for values without a label.
+bool enum_desc_set_add(enum_desc_set_t s, enum_desc_val value) ;
+// Clears every index with this value, false for values without a label.
+bool enum_desc_set_remove(enum_desc_set_t s, enum_desc_val value) ;
+// true if any index with this value is set.
+bool enum_desc_set_contains(enum_desc_set_t s, enum_desc_val value) ;
+
+// Index level, false for a bad index.
+bool enum_desc_set_add_index(enum_desc_set_t s, enum_desc_idx idx) ;
+bool enum_desc_set_remove_index(enum_desc_set_t s, enum_desc_idx idx) ;
+bool enum_desc_set_has_index(enum_desc_set_t s, enum_desc_idx idx) ;
+
+// Number of indexes set.
+int enum_desc_set_count(enum_desc_set_t s) ;
+bool enum_desc_set_equal(enum_desc_set_t a, enum_desc_set_t b) ;
+// true if every member of a is in b.
+bool enum_desc_set_subset(enum_desc_set_t a, enum_desc_set_t b) ;
+
+// dst = a op b. dst may be a or b. false, dst unchanged, when the descriptors differ.
+bool enum_desc_set_union(enum_desc_set_t dst, enum_desc_set_t a, enum_desc_set_t b) ;
+bool enum_desc_set_intersect(enum_desc_set_t dst, enum_desc_set_t a, enum_desc_set_t b) ;
+bool enum_desc_set_difference(enum_desc_set_t dst, enum_desc_set_t a, enum_desc_set_t b) ;
+
+// Next index set after idx, in declaration order. Start with -1, ENUM_DESC_NOT_FOUND at the end.
+enum_desc_idx enum_desc_set_next(enum_desc_set_t s, enum_desc_idx idx) ;
+#define ENUM_DESC_SET_FOREACH(s, idx) \
+	for (enum_desc_idx idx = enum_desc_set_next(s, -1) ; idx != ENUM_DESC_NOT_FOUND ; idx = enum_desc_set_next(s, idx))
+
+// Labels of the members joined by sep ("A,B,C"), in declaration order. snprintf
+// rules: writes at most size bytes with the NUL, returns the full length.
+size_t enum_desc_set_format(enum_desc_set_t s, char sep, char *buf, size_t size) ;
+// Adds the labels in buf, separated by sep. Empty tokens are skipped, len may be
+// (size_t) -1 for a NUL terminated buf. Returns the number of unknown labels.
+size_t enum_desc_set_parse(enum_desc_set_t s, char sep, const char *buf, size_t len) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
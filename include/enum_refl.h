@@ -13,16 +13,30 @@ int enum_refl_value_count(enum_desc_t ed) ;
 enum_desc_val enum_refl_value_of(enum_desc_t ed, const char *name, enum_desc_val default_value) ;
 const char *enum_refl_label_of(enum_desc_t ed, enum_desc_val value, const char *default_label) ;
 void *enum_refl_meta_of(enum_desc_t ed, enum_desc_val value) ;
+// Item of a typed column by value, NULL if the value or the column is unknown.
+const void *enum_refl_column_of(enum_desc_t ed, int col, enum_desc_val value) ;
 void *enum_refl_state_of(enum_desc_t ed, enum_desc_val value) ;
 
 enum_desc_idx enum_refl_find_by_value(enum_desc_t ed, enum_desc_val value) ;
 enum_desc_idx enum_refl_find_by_label(enum_desc_t ed, const char *label) ;
 
+// Per-thread cache of recent value lookups, used by enum_refl_find_by_value,
+// enum_refl_label_of and enum_refl_state_of. Off by default, set per thread.
+struct enum_refl_cache_stats {
+	uint64_t hits ;
+	uint64_t misses ;
+} ;
+void enum_refl_cache_enable(bool enable) ;
+// Counters of the calling thread.
+void enum_refl_cache_stats(struct enum_refl_cache_stats *stats, bool reset) ;
+
 enum_desc_val enum_refl_value_at(enum_desc_t ed, enum_desc_idx idx) ;
 const char * enum_refl_label_at(enum_desc_t ed, enum_desc_idx idx) ;
 void *enum_refl_meta_at(enum_desc_t ed, enum_desc_idx idx) ;
 void *enum_refl_state_at(enum_desc_t ed, enum_desc_idx idx) ;
 
+typedef struct enum_desc_arena *enum_desc_arena_t ;
+
 struct enum_desc_entry {
 	enum_desc_val value ;
 	const char *name ;
@@ -30,8 +44,77 @@ struct enum_desc_entry {
 }  ;
 
 enum_desc_t enum_refl_build(const char *name, struct enum_desc_entry entries[], enum_desc_ext_t ext) ;
+
+// Extra label set for enum_refl_build_sets: one label per entry, in entry order.
+struct enum_desc_label_set_def {
+	const char *name ;
+	const char *const *labels ;
+} ;
+// arena may be NULL. Labels are copied.
+enum_desc_t enum_refl_build_sets(enum_desc_arena_t arena, const char *name, struct enum_desc_entry entries[], enum_desc_ext_t ext,
+	const struct enum_desc_label_set_def *sets, int set_count) ;
+
+// Typed column for enum_refl_build_with: size bytes per entry, data in entry order. Copied.
+struct enum_desc_column_def {
+	const char *name ;
+	size_t size ;
+	const void *data ;
+} ;
+// Optional parts of a built descriptor, zero for none.
+struct enum_refl_build_opts {
+	const struct enum_desc_label_set_def *sets ;
+	int set_count ;
+	const struct enum_desc_column_def *columns ;
+	int column_count ;
+} ;
+// arena and opts may be NULL. Meta is stored sparse when few entries have it.
+enum_desc_t enum_refl_build_with(enum_desc_arena_t arena, const char *name, struct enum_desc_entry entries[], enum_desc_ext_t ext,
+	const struct enum_refl_build_opts *opts) ;
 void enum_refl_destroy(enum_desc_t ed) ;
 
+// Shared descriptor for identical content (name, values, labels, meta pointers, ext),
+// built on first use. Each call takes a reference, enum_desc_destroy drops it and the
+// last one frees the descriptor. Thread safe, lookups of existing content take no lock.
+enum_desc_t enum_refl_build_interned(const char *name, struct enum_desc_entry entries[], enum_desc_ext_t ext) ;
+// Interned descriptors alive, and calls that found an existing one.
+void enum_refl_intern_stats(size_t *live, size_t *hits) ;
+
+// Arena for descriptors created and dropped together. Each descriptor and its
+// arrays are placed contiguously, enum_desc_destroy is a no-op on them.
+// An arena is not thread safe, build into it from one thread at a time.
+// chunk_size 0 for the default (64KB)
+enum_desc_arena_t enum_desc_arena_create(size_t chunk_size) ;
+enum_desc_t enum_refl_build_in(enum_desc_arena_t arena, const char *name, struct enum_desc_entry entries[], enum_desc_ext_t ext) ;
+// Bytes handed out, and reserved from malloc.
+void enum_desc_arena_usage(enum_desc_arena_t arena, size_t *used, size_t *reserved) ;
+// Releases every descriptor built in the arena, and the arena.
+void enum_desc_arena_release(enum_desc_arena_t arena) ;
+
+// Bulk transcoding. Input is split into contiguous chunks, one per job, output
+// order matches input order. Descriptors are read-only, no locking is needed.
+typedef void (*enum_refl_job_fn)(void *job_cxt, int job_idx) ;
+// Thread pool hook: run job(job_cxt, i) for i in [0, njobs), return when all are done.
+typedef void (*enum_refl_runner_fn)(void *runner_cxt, int njobs, enum_refl_job_fn job, void *job_cxt) ;
+
+struct enum_refl_bulk_opts {
+	int nthreads ;                      // number of jobs, <=1 runs on the calling thread
+	enum_refl_runner_fn runner ;        // optional thread pool, NULL for one pthread per job
+	void *runner_cxt ;
+	size_t *unknown_idx ;               // optional, receives positions of unknown inputs, ascending
+	size_t unknown_max ;                // capacity of unknown_idx
+} ;
+
+// All return the total number of unknown inputs (opts may be NULL).
+size_t enum_refl_bulk_label_of(enum_desc_t ed, const enum_desc_val *values, size_t n,
+	const char **labels, const char *default_label, const struct enum_refl_bulk_opts *opts) ;
+size_t enum_refl_bulk_value_of(enum_desc_t ed, const char *const *labels, size_t n,
+	enum_desc_val *values, enum_desc_val default_value, const struct enum_refl_bulk_opts *opts) ;
+// Parse sep-terminated labels from buf. *count_out gets the number of tokens,
+// at most values_max are stored.
+size_t enum_refl_bulk_parse(enum_desc_t ed, const char *buf, size_t len, char sep,
+	enum_desc_val *values, size_t values_max, size_t *count_out,
+	enum_desc_val default_value, const struct enum_refl_bulk_opts *opts) ;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,93 @@
+#include "enum_refl.h"
+#include "enum_desc_impl.h"
+#include <stddef.h>
+
+//--------------------------------------------------------------------------------
+// Bump allocator for descriptors built with enum_refl_build_in. Memory is only
+// returned to malloc by enum_desc_arena_release.
+//--------------------------------------------------------------------------------
+
+#define ARENA_CHUNK_DEFAULT (64*1024)
+#define ARENA_ALIGN _Alignof(max_align_t)
+
+struct arena_chunk {
+	struct arena_chunk *next ;
+	size_t size, used ;
+	max_align_t data[] ;
+} ;
+
+struct arena_desc {
+	struct arena_desc *next ;
+	enum_desc_t ed ;
+} ;
+
+struct enum_desc_arena {
+	struct arena_chunk *chunks ;        // current chunk first
+	struct arena_desc *descs ;          // most recent first
+	size_t chunk_size ;
+	size_t used, reserved ;
+} ;
+
+enum_desc_arena_t enum_desc_arena_create(size_t chunk_size)
+{
+	struct enum_desc_arena *arena = calloc(1, sizeof(*arena)) ;
+	if ( !arena ) return NULL ;
+	arena->chunk_size = chunk_size ? chunk_size : ARENA_CHUNK_DEFAULT ;
+	return arena ;
+}
+
+static struct arena_chunk *new_chunk(struct enum_desc_arena *arena, size_t min_size)
+{
+	size_t size = min_size > arena->chunk_size ? min_size : arena->chunk_size ;
+	struct arena_chunk *chunk = malloc(sizeof(*chunk) + size) ;
+	if ( !chunk ) return NULL ;
+	*chunk = (struct arena_chunk) { .size = size } ;
+	arena->reserved += size ;
+	if ( size > arena->chunk_size && arena->chunks ) {
+		// Oversized: keep the current chunk for the next small allocations.
+		chunk->next = arena->chunks->next ;
+		arena->chunks->next = chunk ;
+	} else {
+		chunk->next = arena->chunks ;
+		arena->chunks = chunk ;
+	}
+	return chunk ;
+}
+
+void *enum_desc_alloc(struct enum_desc_arena *arena, size_t n, size_t size)
+{
+	if ( !arena ) return calloc(n, size) ;
+	size_t bytes = (n * size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1) ;
+	struct arena_chunk *chunk = arena->chunks ;
+	if ( !chunk || chunk->size - chunk->used < bytes ) chunk = new_chunk(arena, bytes) ;
+	if ( !chunk ) return NULL ;
+	void *p = (char *) chunk->data + chunk->used ;
+	chunk->used += bytes ;
+	arena->used += bytes ;
+	return memset(p, 0, bytes) ;
+}
+
+void enum_desc_arena_add(struct enum_desc_arena *arena, enum_desc_t ed)
+{
+	struct arena_desc *node = enum_desc_alloc(arena, 1, sizeof(*node)) ;
+	if ( !node ) return ;
+	*node = (struct arena_desc) { .next = arena->descs, .ed = ed } ;
+	arena->descs = node ;
+}
+
+void enum_desc_arena_usage(enum_desc_arena_t arena, size_t *used, size_t *reserved)
+{
+	if ( used ) *used = arena->used ;
+	if ( reserved ) *reserved = arena->reserved ;
+}
+
+void enum_desc_arena_release(enum_desc_arena_t arena)
+{
+	if ( !arena ) return ;
+	for (struct arena_desc *d = arena->descs ; d ; d = d->next) enum_desc_release_state(d->ed) ;
+	for (struct arena_chunk *chunk = arena->chunks, *next ; chunk ; chunk = next) {
+		next = chunk->next ;
+		free(chunk) ;
+	}
+	free(arena) ;
+}
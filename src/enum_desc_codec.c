@@ -0,0 +1,112 @@
+#include "enum_desc_codec.h"
+#include "enum_desc_inline.h"
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_AVX2_DISPATCH 1
+#endif
+
+struct enum_desc_codec {
+	enum_desc_t ed ;
+	int bits ;
+	uint32_t escape ;                   // value_count: code for values without a label
+	enum_desc_val default_value ;
+} ;
+
+enum_desc_codec_t enum_desc_codec_create(enum_desc_t ed, enum_desc_val default_value)
+{
+	if ( enum_desc_value_count(ed) < 1 ) return NULL ;
+	struct enum_desc_codec *c = calloc(1, sizeof(*c)) ;
+	if ( !c ) return NULL ;
+	c->ed = ed ;
+	c->escape = enum_desc_value_count(ed) ;
+	c->bits = 32 - __builtin_clz(c->escape) ;
+	c->default_value = default_value ;
+	return c ;
+}
+
+void enum_desc_codec_destroy(enum_desc_codec_t c)
+{
+	free((void *) c) ;
+}
+
+int enum_desc_codec_bits(enum_desc_codec_t c)
+{
+	return c->bits ;
+}
+
+size_t enum_desc_codec_size(enum_desc_codec_t c, size_t n)
+{
+	return (n * c->bits + 7) / 8 ;
+}
+
+size_t enum_desc_codec_encode(enum_desc_codec_t c, const enum_desc_val *vals, size_t n, void *out)
+{
+	uint8_t *p = out ;
+	uint64_t acc = 0 ;
+	int acc_bits = 0 ;
+	size_t unknown = 0 ;
+	for (size_t i=0 ; i<n ; i++) {
+		enum_desc_idx idx = enum_desc_inline_find_by_value(c->ed, vals[i]) ;
+		uint32_t code = idx == ENUM_DESC_NOT_FOUND ? c->escape : (uint32_t) idx ;
+		unknown += idx == ENUM_DESC_NOT_FOUND ;
+		acc |= (uint64_t) code << acc_bits ;
+		acc_bits += c->bits ;
+		for ( ; acc_bits >= 8 ; acc_bits -= 8, acc >>= 8) *p++ = (uint8_t) acc ;
+	}
+	if ( acc_bits ) *p = (uint8_t) acc ;
+	return unknown ;
+}
+
+// Item at bit off: at most 3 bytes (7 bit shift + 16 bit code), none past the item.
+static uint32_t code_at(const uint8_t *in, uint64_t off, int bits)
+{
+	const uint8_t *p = in + (off >> 3) ;
+	int shift = off & 7, len = (shift + bits + 7) >> 3 ;
+	uint32_t word = 0 ;
+	for (int k=0 ; k<len ; k++) word |= (uint32_t) p[k] << (8 * k) ;
+	return (word >> shift) & ((1u << bits) - 1) ;
+}
+
+#if HAVE_AVX2_DISPATCH
+// 8 items per step: one 32 bit gather at each item's byte, shift and mask, then a
+// gather from values[] for known codes. Stops where a 4 byte load would pass the end.
+__attribute__((target("avx2")))
+static size_t decode_avx2(enum_desc_codec_t c, const uint8_t *in, size_t size, size_t first, size_t n, enum_desc_val *vals, size_t *unknown)
+{
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) ;
+	const __m256i step = _mm256_mullo_epi32(lane, _mm256_set1_epi32(c->bits)) ;
+	const __m256i mask = _mm256_set1_epi32((1u << c->bits) - 1) ;
+	const __m256i seven = _mm256_set1_epi32(7) ;
+	const __m256i escape = _mm256_set1_epi32(c->escape) ;
+	const __m256i dflt = _mm256_set1_epi32(c->default_value) ;
+	const int *values = c->ed->values ;
+	size_t i = 0 ;
+	for ( ; i + 8 <= n ; i += 8 ) {
+		uint64_t off = (first + i) * c->bits ;
+		if ( ((off + 7 * c->bits) >> 3) + 4 > size ) break ;
+		__m256i rel = _mm256_add_epi32(_mm256_set1_epi32(off & 7), step) ;
+		__m256i word = _mm256_i32gather_epi32((const int *) (in + (off >> 3)), _mm256_srli_epi32(rel, 3), 1) ;
+		__m256i code = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(rel, seven)), mask) ;
+		__m256i known = _mm256_cmpgt_epi32(escape, code) ;
+		__m256i v = _mm256_mask_i32gather_epi32(dflt, values, code, known, 4) ;
+		_mm256_storeu_si256((__m256i *) (vals + i), v) ;
+		*unknown += 8 - __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(known))) ;
+	}
+	return i ;
+}
+#endif
+
+size_t enum_desc_codec_decode(enum_desc_codec_t c, const void *in, size_t size, size_t first, size_t n, enum_desc_val *vals)
+{
+	if ( first + n < first || enum_desc_codec_size(c, first + n) > size ) return (size_t) -1 ;
+	size_t i = 0, unknown = 0 ;
+#if HAVE_AVX2_DISPATCH
+	if ( __builtin_cpu_supports("avx2") ) i = decode_avx2(c, in, size, first, n, vals, &unknown) ;
+#endif
+	for ( ; i<n ; i++) {
+		uint32_t code = code_at(in, (first + i) * c->bits, c->bits) ;
+		unknown += code >= c->escape ;
+		vals[i] = code < c->escape ? c->ed->values[code] : c->default_value ;
+	}
+	return unknown ;
+}
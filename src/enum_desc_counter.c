@@ -0,0 +1,109 @@
+#include "enum_desc_counter.h"
+#include "enum_desc_def.h"
+#include <stdalign.h>
+#include <stdatomic.h>
+
+//--------------------------------------------------------------------------------
+// Per-thread counter arrays. A thread finds its array through a small direct
+// mapped table keyed by counter id, ids are never reused so a destroyed counter
+// can not match. Arrays are pushed on the counter's list once and only freed by
+// enum_desc_counter_destroy. Each array has one writer: plain relaxed load and
+// store on the owner side, relaxed loads in snapshots.
+//--------------------------------------------------------------------------------
+
+#define COUNTER_LINE 64
+#ifndef ENUM_DESC_COUNTER_TLS_SLOTS
+#define ENUM_DESC_COUNTER_TLS_SLOTS 16  // power of 2
+#endif
+
+struct counter_slab {
+	struct counter_slab *next ;
+	const void *owner ;                 // address of the owner's thread local, unique while it runs
+	alignas(COUNTER_LINE) uint64_t counts[] ;   // [value_count + 1], last is overflow
+} ;
+
+struct enum_desc_counter {
+	enum_desc_t ed ;
+	uint64_t id ;
+	int count ;                         // value_count
+	_Atomic(struct counter_slab *) slabs ;
+} ;
+
+struct counter_tls {
+	uint64_t id ;
+	uint64_t *counts ;
+} ;
+
+static atomic_uint_fast64_t counter_next_id = 1 ;
+static _Thread_local struct counter_tls counter_tls[ENUM_DESC_COUNTER_TLS_SLOTS] ;
+
+enum_desc_counter_t enum_desc_counter_create(enum_desc_t ed)
+{
+	struct enum_desc_counter *c = calloc(1, sizeof(*c)) ;
+	if ( !c ) return NULL ;
+	c->ed = ed ;
+	c->count = enum_desc_value_count(ed) ;
+	c->id = atomic_fetch_add_explicit(&counter_next_id, 1, memory_order_relaxed) ;
+	return c ;
+}
+
+void enum_desc_counter_destroy(enum_desc_counter_t c)
+{
+	if ( !c ) return ;
+	for (struct counter_slab *s = atomic_load_explicit(&c->slabs, memory_order_acquire), *next ; s ; s = next) {
+		next = s->next ;
+		free(s) ;
+	}
+	free(c) ;
+}
+
+// Slow path: the thread's array, adopted from the list when the table entry was
+// evicted (or left by an exited thread at the same address), else a new one.
+static uint64_t *thread_counts(enum_desc_counter_t c, struct counter_tls *tls)
+{
+	const void *owner = counter_tls ;
+	struct counter_slab *s ;
+	for (s = atomic_load_explicit(&c->slabs, memory_order_acquire) ; s ; s = s->next)
+		if ( s->owner == owner ) break ;
+	if ( !s ) {
+		size_t size = sizeof(*s) + (c->count + 1) * sizeof(uint64_t) ;
+		size = (size + COUNTER_LINE - 1) & ~(size_t) (COUNTER_LINE - 1) ;
+		s = aligned_alloc(COUNTER_LINE, size) ;
+		if ( !s ) return NULL ;
+		memset(s, 0, size) ;
+		s->owner = owner ;
+		s->next = atomic_load_explicit(&c->slabs, memory_order_relaxed) ;
+		while ( !atomic_compare_exchange_weak_explicit(&c->slabs, &s->next, s, memory_order_release, memory_order_relaxed) ) ;
+	}
+	*tls = (struct counter_tls) { .id = c->id, .counts = s->counts } ;
+	return s->counts ;
+}
+
+void enum_desc_counter_add(enum_desc_counter_t c, enum_desc_val value, uint64_t n)
+{
+	struct counter_tls *tls = &counter_tls[c->id & (ENUM_DESC_COUNTER_TLS_SLOTS-1)] ;
+	uint64_t *counts = tls->id == c->id ? tls->counts : thread_counts(c, tls) ;
+	if ( !counts ) return ;
+	enum_desc_idx idx = enum_desc_find_by_value(c->ed, value) ;
+	uint64_t *slot = &counts[idx == ENUM_DESC_NOT_FOUND ? c->count : idx] ;
+	__atomic_store_n(slot, __atomic_load_n(slot, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED) ;
+}
+
+void enum_desc_counter_snapshot(enum_desc_counter_t c, uint64_t *counts)
+{
+	memset(counts, 0, (c->count + 1) * sizeof(*counts)) ;
+	for (struct counter_slab *s = atomic_load_explicit(&c->slabs, memory_order_acquire) ; s ; s = s->next)
+		for (int i=0 ; i<=c->count ; i++) counts[i] += __atomic_load_n(&s->counts[i], __ATOMIC_RELAXED) ;
+}
+
+void enum_desc_counter_print(FILE *fp, enum_desc_counter_t c)
+{
+	uint64_t *counts = calloc(c->count + 1, sizeof(*counts)) ;
+	if ( !counts ) return ;
+	enum_desc_counter_snapshot(c, counts) ;
+	fprintf(fp, "Counters '%s'\n", enum_desc_name(c->ed)) ;
+	for (int i=0 ; i<c->count ; i++)
+		if ( counts[i] ) fprintf(fp, "%s: %llu\n", enum_desc_label_at(c->ed, i), (unsigned long long) counts[i]) ;
+	if ( counts[c->count] ) fprintf(fp, "(other): %llu\n", (unsigned long long) counts[c->count]) ;
+	free(counts) ;
+}
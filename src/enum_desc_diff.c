@@ -0,0 +1,85 @@
+#include "enum_refl.h"
+#include "enum_desc_def.h"
+#include "enum_desc_impl.h"
+
+//--------------------------------------------------------------------------------
+// Content fingerprint and diff. The byte stream hashed here is also built by the
+// plugin (content_fingerprint in gcc_enum_reflect.cc), keep them in step.
+//--------------------------------------------------------------------------------
+
+#define FNV64_BASIS UINT64_C(14695981039346656037)
+#define FNV64_PRIME UINT64_C(1099511628211)
+
+static uint64_t fnv_bytes(uint64_t h, const void *p, size_t n)
+{
+	const unsigned char *s = p ;
+	for (size_t i=0 ; i<n ; i++) h = (h ^ s[i]) * FNV64_PRIME ;
+	return h ;
+}
+
+static uint64_t fnv_item(uint64_t h, const char *label, enum_desc_val value)
+{
+	uint32_t v = (uint32_t) value ;
+	const unsigned char le[4] = { v, v >> 8, v >> 16, v >> 24 } ;
+	h = fnv_bytes(h, label, strlen(label)+1) ;
+	return fnv_bytes(h, le, sizeof(le)) ;
+}
+
+uint64_t enum_desc_fingerprint_of(const char *name, const struct enum_desc_entry *entries, int count)
+{
+	uint64_t h = fnv_bytes(FNV64_BASIS, name, strlen(name)+1) ;
+	for (int i=0 ; i<count ; i++) h = fnv_item(h, entries[i].name, entries[i].value) ;
+	return h ? h : 1 ;
+}
+
+uint64_t enum_desc_fingerprint(enum_desc_t ed)
+{
+	if ( ed->fingerprint ) return ed->fingerprint ;
+	// Hand written and older plugin descriptors
+	uint64_t h = fnv_bytes(FNV64_BASIS, enum_desc_name(ed), strlen(enum_desc_name(ed))+1) ;
+	for (int i=0 ; i<ed->value_count ; i++) h = fnv_item(h, enum_desc_label_at(ed, i), ed->values[i]) ;
+	return h ? h : 1 ;
+}
+
+// Walks a's labels through b's label lookup, then b's labels through a's.
+// fp: print each difference.
+static int diff(enum_desc_t a, enum_desc_t b, struct enum_desc_diff *out, FILE *fp)
+{
+	struct enum_desc_diff d = { 0 } ;
+	if ( enum_desc_fingerprint(a) != enum_desc_fingerprint(b) ) {
+		d.name = strcmp(enum_desc_name(a), enum_desc_name(b)) != 0 ;
+		if ( d.name && fp ) fprintf(fp, "name %s -> %s\n", enum_desc_name(a), enum_desc_name(b)) ;
+		for (int i=0 ; i<a->value_count ; i++) {
+			const char *label = enum_desc_label_at(a, i) ;
+			enum_desc_idx j = enum_desc_find_by_label(b, label) ;
+			if ( j == ENUM_DESC_NOT_FOUND ) {
+				d.only_a++ ;
+				if ( fp ) fprintf(fp, "-%s\n", label) ;
+			} else if ( a->values[i] != b->values[j] ) {
+				d.value_changed++ ;
+				if ( fp ) fprintf(fp, "~%s %d -> %d\n", label, (int) a->values[i], (int) b->values[j]) ;
+			} else if ( i != j ) {
+				d.moved++ ;
+				if ( fp ) fprintf(fp, ">%s #%d -> #%d\n", label, i, (int) j) ;
+			}
+		}
+		for (int j=0 ; j<b->value_count ; j++) {
+			const char *label = enum_desc_label_at(b, j) ;
+			if ( enum_desc_find_by_label(a, label) != ENUM_DESC_NOT_FOUND ) continue ;
+			d.only_b++ ;
+			if ( fp ) fprintf(fp, "+%s\n", label) ;
+		}
+	}
+	if ( out ) *out = d ;
+	return d.name + d.only_a + d.only_b + d.value_changed + d.moved ;
+}
+
+int enum_desc_diff(enum_desc_t a, enum_desc_t b, struct enum_desc_diff *out)
+{
+	return diff(a, b, out, NULL) ;
+}
+
+void enum_desc_diff_print(FILE *fp, enum_desc_t a, enum_desc_t b)
+{
+	diff(a, b, NULL, fp) ;
+}
@@ -0,0 +1,48 @@
+#ifndef _ENUM_DESC_IMPL_H_
+#define _ENUM_DESC_IMPL_H_
+
+// Library internal helpers, not installed.
+
+#include "enum_desc_def.h"
+#include <stdbool.h>
+
+struct enum_desc_arena ;
+struct enum_desc_entry ;
+
+// Arena (enum_desc_arena.c).
+// Zeroed memory from arena, calloc when arena is NULL.
+void *enum_desc_alloc(struct enum_desc_arena *arena, size_t n, size_t size) ;
+// Keep ed for teardown by enum_desc_arena_release.
+void enum_desc_arena_add(struct enum_desc_arena *arena, enum_desc_t ed) ;
+// Teardown that is not freeing storage: ext destroy, lookup caches, materialized labels (enum_reflect.c).
+void enum_desc_release_state(enum_desc_t ed) ;
+
+// Interning (enum_desc_intern.c). Drops one reference of an ENUM_DESC_F_INTERNED descriptor.
+void enum_desc_intern_release(enum_desc_t ed) ;
+
+// Fingerprint (enum_desc_diff.c) of a descriptor about to be built, see enum_desc_fingerprint.
+uint64_t enum_desc_fingerprint_of(const char *name, const struct enum_desc_entry *entries, int count) ;
+
+// Label trie (enum_desc_trie.c).
+// base != NULL: labels point into base, edges reference it. NULL: edges are copied to a private blob.
+struct enum_desc_trie *enum_desc_trie_build(struct enum_desc_arena *arena, const char *const *labels, int count, const char *base) ;
+void enum_desc_trie_free(const struct enum_desc_trie *trie, bool own_segs) ;
+
+// Child of node whose edge starts with c, -1 if none. Children are sorted by first byte.
+static inline int enum_desc_trie_child(const struct enum_desc_trie *trie, int node, unsigned char c)
+{
+	int lo = trie->child[node], hi = trie->child[node+1] ;
+	while ( lo < hi ) {
+		int mid = (lo + hi) / 2 ;
+		unsigned char m = trie->segs[trie->seg_off[mid]] ;
+		if ( m == c ) return mid ;
+		if ( m < c ) lo = mid + 1 ; else hi = mid ;
+	}
+	return -1 ;
+}
+
+enum_desc_idx enum_desc_trie_find(const struct enum_desc_trie *trie, const char *s, size_t len) ;
+// Label length, bytes beyond size-1 are dropped. buf is always NUL terminated when size > 0.
+int enum_desc_trie_copy(const struct enum_desc_trie *trie, enum_desc_idx idx, char *buf, size_t size) ;
+
+#endif
@@ -0,0 +1,137 @@
+#include "enum_desc_index.h"
+#include "enum_desc_def.h"
+
+// Matches for one label are stored as a contiguous run, each hash slot points to a run.
+struct index_slot {
+	uint32_t hash ;
+	uint32_t first ;                    // first match in matches[], count 0 = empty slot
+	uint32_t count ;
+} ;
+
+struct enum_desc_index {
+	uint32_t mask ;                     // slot count - 1
+	struct index_slot *slots ;
+	struct enum_desc_match *matches ;
+} ;
+
+struct index_item {
+	uint32_t hash ;
+	uint32_t order ;                    // build order, keeps runs deterministic
+	const char *label ;
+	struct enum_desc_match m ;
+} ;
+
+static uint32_t label_hash(const char *s, size_t len)
+{
+	uint32_t h = 2166136261u ;          // FNV-1a
+	for (size_t i=0 ; i<len ; i++) h = (h ^ (unsigned char) s[i]) * 16777619u ;
+	return h ;
+}
+
+static int cmp_item(const void *a, const void *b)
+{
+	const struct index_item *x = a, *y = b ;
+	if ( x->hash != y->hash ) return x->hash < y->hash ? -1 : 1 ;
+	int c = strcmp(x->label, y->label) ;
+	if ( c ) return c ;
+	return x->order < y->order ? -1 : x->order > y->order ;
+}
+
+static bool same_desc(enum_desc_t a, enum_desc_t b)
+{
+	if ( a->value_count != b->value_count || strcmp(enum_desc_name(a), enum_desc_name(b)) ) return false ;
+	for (int i=0 ; i<a->value_count ; i++) {
+		if ( enum_desc_value_at(a, i) != enum_desc_value_at(b, i) ) return false ;
+		if ( strcmp(enum_desc_label_at(a, i), enum_desc_label_at(b, i)) ) return false ;
+	}
+	return true ;
+}
+
+enum_desc_index_t enum_desc_index_build(const enum_desc_t eds[], int count)
+{
+	size_t total = 0 ;
+	for (int d=0 ; d<count ; d++) total += eds[d]->value_count ;
+
+	struct index_item *items = calloc(total+1, sizeof(*items)) ;
+	struct enum_desc_index *index = calloc(1, sizeof(*index)) ;
+	uint32_t nslots = 8 ;
+	while ( nslots < 2*total ) nslots *= 2 ;
+	index->mask = nslots - 1 ;
+	index->slots = calloc(nslots, sizeof(*index->slots)) ;
+	index->matches = calloc(total+1, sizeof(*index->matches)) ;
+
+	size_t n = 0 ;
+	for (int d=0 ; d<count ; d++) {
+		// The same enum reflected in several translation units is indexed once.
+		bool dup = false ;
+		for (int k=0 ; k<d && !dup ; k++) dup = eds[k] == eds[d] || same_desc(eds[k], eds[d]) ;
+		if ( dup ) continue ;
+		for (int i=0 ; i<eds[d]->value_count ; i++) {
+			const char *label = enum_desc_label_at(eds[d], i) ;
+			items[n] = (struct index_item) {
+				.hash = label_hash(label, strlen(label)), .order = n, .label = label,
+				.m = { .ed = eds[d], .idx = i },
+			} ;
+			n++ ;
+		}
+	}
+	qsort(items, n, sizeof(*items), cmp_item) ;
+
+	for (size_t i=0 ; i<n ; ) {
+		size_t j = i+1 ;
+		while ( j<n && items[j].hash == items[i].hash && !strcmp(items[j].label, items[i].label) ) j++ ;
+		uint32_t s = items[i].hash & index->mask ;
+		while ( index->slots[s].count ) s = (s+1) & index->mask ;
+		index->slots[s] = (struct index_slot) { .hash = items[i].hash, .first = i, .count = j-i } ;
+		for (size_t k=i ; k<j ; k++) index->matches[k] = items[k].m ;
+		i = j ;
+	}
+	free(items) ;
+	return index ;
+}
+
+int enum_desc_index_lookup(enum_desc_index_t index, const char *label, size_t len, const struct enum_desc_match **matches)
+{
+	uint32_t h = label_hash(label, len) ;
+	for (uint32_t s = h & index->mask ; index->slots[s].count ; s = (s+1) & index->mask) {
+		const struct index_slot *slot = &index->slots[s] ;
+		if ( slot->hash != h ) continue ;
+		const struct enum_desc_match *m = &index->matches[slot->first] ;
+		const char *l = enum_desc_label_at(m->ed, m->idx) ;
+		if ( strnlen(l, len + 1) != len || memcmp(l, label, len) ) continue ;      // label may hold NULs
+		if ( matches ) *matches = m ;
+		return slot->count ;
+	}
+	if ( matches ) *matches = NULL ;
+	return 0 ;
+}
+
+void enum_desc_index_destroy(enum_desc_index_t index)
+{
+	if ( !index ) return ;
+	free(index->slots) ;
+	free(index->matches) ;
+	free((void *) index) ;
+}
+
+//--------------------------------------------------------------------------------
+// Registry: the plugin places a pointer to each descriptor it emits in section
+// enum_desc_reg, the linker provides the bounds.
+//--------------------------------------------------------------------------------
+
+extern const enum_desc_t __start_enum_desc_reg[] __attribute__((weak, visibility("hidden"))) ;
+extern const enum_desc_t __stop_enum_desc_reg[] __attribute__((weak, visibility("hidden"))) ;
+
+const enum_desc_t *enum_desc_registry(int *count)
+{
+	const enum_desc_t *begin = __start_enum_desc_reg, *end = __stop_enum_desc_reg ;
+	if ( count ) *count = begin && end ? end - begin : 0 ;
+	return begin ;
+}
+
+enum_desc_index_t enum_desc_index_build_registry(void)
+{
+	int count ;
+	const enum_desc_t *eds = enum_desc_registry(&count) ;
+	return enum_desc_index_build(eds, count) ;
+}
@@ -0,0 +1,440 @@
+// enum_desc_inspect: list the plugin descriptors embedded in ELF objects and executables.
+//
+//   enum_desc_inspect file...
+//
+// Finds __enum_desc__<E> symbols, decodes them with struct enum_desc and reports per
+// enum: item count, bytes reachable from the header, 64 byte lines holding the hot
+// parts (header, values, label offsets, labels), the value index present and the one
+// suited to the value distribution. Descriptors with the same name in several places
+// are listed at the end, with the bytes the extra identical copies cost.
+//
+// Reads 64 bit little endian ELF built for the same ABI as the tool (struct enum_desc
+// layout). Pointers are resolved through relocations: section relative for objects,
+// RELATIVE relocations or stored addresses for executables and shared objects.
+
+#include <elf.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "enum_desc_def.h"
+
+#define DESC_SYM_PREFIX "__enum_desc__"
+#define LINE_SIZE 64
+
+struct loc {
+	int sec ;                           // 0: null pointer
+	uint64_t off ;                      // offset in the section
+} ;
+
+struct reloc {
+	struct loc at, to ;
+} ;
+
+struct elf_file {
+	const char *path ;
+	const unsigned char *map ;
+	size_t size ;
+	const Elf64_Ehdr *eh ;
+	const Elf64_Shdr *sh ;
+	int shnum ;
+	bool linked ;                       // executable or shared object: section addresses are set
+	struct reloc *relocs ;              // sorted by at
+	int reloc_count ;
+} ;
+
+struct desc_info {
+	const char *file ;
+	const char *name ;
+	int count, uniq ;
+	enum_desc_val min, max ;
+	size_t bytes ;
+	int lines ;
+	uint64_t hash ;
+	char has[64] ;
+	const char *lookup ;
+} ;
+
+static int cmp_loc(struct loc a, struct loc b)
+{
+	if ( a.sec != b.sec ) return a.sec < b.sec ? -1 : 1 ;
+	return a.off < b.off ? -1 : a.off > b.off ;
+}
+
+static int cmp_reloc(const void *a, const void *b)
+{
+	return cmp_loc(((const struct reloc *) a)->at, ((const struct reloc *) b)->at) ;
+}
+
+// Section holding a virtual address, for linked files. .tbss takes no address space.
+static struct loc loc_of_addr(const struct elf_file *f, uint64_t addr)
+{
+	for (int s=1 ; s<f->shnum ; s++) {
+		const Elf64_Shdr *sh = &f->sh[s] ;
+		if ( (sh->sh_flags & SHF_TLS) && sh->sh_type == SHT_NOBITS ) continue ;
+		if ( (sh->sh_flags & SHF_ALLOC) && addr >= sh->sh_addr && addr < sh->sh_addr + sh->sh_size )
+			return (struct loc) { .sec = s, .off = addr - sh->sh_addr } ;
+	}
+	return (struct loc) { 0 } ;
+}
+
+// File bytes at l, NULL if outside the file or in a section without contents.
+static const void *data_at(const struct elf_file *f, struct loc l, size_t size)
+{
+	if ( l.sec <= 0 || l.sec >= f->shnum ) return NULL ;
+	const Elf64_Shdr *sh = &f->sh[l.sec] ;
+	if ( sh->sh_type == SHT_NOBITS || l.off + size > sh->sh_size || sh->sh_offset + l.off + size > f->size ) return NULL ;
+	return f->map + sh->sh_offset + l.off ;
+}
+
+static const char *str_at(const struct elf_file *f, struct loc l)
+{
+	const Elf64_Shdr *sh = &f->sh[l.sec] ;
+	const char *s = data_at(f, l, 1) ;
+	if ( !s || !memchr(s, 0, sh->sh_size - l.off) ) return NULL ;
+	return s ;
+}
+
+static bool is_abs64(const struct elf_file *f, unsigned type)
+{
+	switch ( f->eh->e_machine ) {
+	case EM_X86_64: return type == R_X86_64_64 ;
+	case EM_AARCH64: return type == R_AARCH64_ABS64 ;
+	}
+	return false ;
+}
+
+static bool is_relative(const struct elf_file *f, unsigned type)
+{
+	switch ( f->eh->e_machine ) {
+	case EM_X86_64: return type == R_X86_64_RELATIVE ;
+	case EM_AARCH64: return type == R_AARCH64_RELATIVE ;
+	}
+	return false ;
+}
+
+static void load_relocs(struct elf_file *f)
+{
+	int cap = 0 ;
+	for (int s=1 ; s<f->shnum ; s++) {
+		const Elf64_Shdr *sh = &f->sh[s] ;
+		if ( sh->sh_type != SHT_RELA || sh->sh_link >= (unsigned) f->shnum ) continue ;
+		const Elf64_Rela *r = data_at(f, (struct loc) { s, 0 }, sh->sh_size) ;
+		const Elf64_Shdr *symsh = &f->sh[sh->sh_link] ;
+		const Elf64_Sym *syms = sh->sh_link ? data_at(f, (struct loc) { sh->sh_link, 0 }, symsh->sh_size) : NULL ;
+		size_t nsyms = syms ? symsh->sh_size / sizeof(*syms) : 0 ;
+		if ( !r ) continue ;
+		for (size_t k=0 ; k < sh->sh_size / sizeof(*r) ; k++) {
+			unsigned type = ELF64_R_TYPE(r[k].r_info) ;
+			size_t symi = ELF64_R_SYM(r[k].r_info) ;
+			struct reloc rel ;
+			if ( f->linked && is_relative(f, type) ) {
+				rel = (struct reloc) { loc_of_addr(f, r[k].r_offset), loc_of_addr(f, r[k].r_addend) } ;
+			} else if ( is_abs64(f, type) && symi < nsyms ) {
+				const Elf64_Sym *sym = &syms[symi] ;
+				if ( sym->st_shndx == SHN_UNDEF || sym->st_shndx >= SHN_LORESERVE ) continue ;
+				uint64_t target = sym->st_value + r[k].r_addend ;
+				if ( f->linked )
+					rel = (struct reloc) { loc_of_addr(f, r[k].r_offset), loc_of_addr(f, target) } ;
+				else
+					rel = (struct reloc) { { sh->sh_info, r[k].r_offset }, { sym->st_shndx, target } } ;
+			} else {
+				continue ;
+			}
+			if ( f->reloc_count == cap ) {
+				cap = cap ? 2*cap : 256 ;
+				f->relocs = realloc(f->relocs, cap * sizeof(*f->relocs)) ;
+			}
+			f->relocs[f->reloc_count++] = rel ;
+		}
+	}
+	qsort(f->relocs, f->reloc_count, sizeof(*f->relocs), cmp_reloc) ;
+}
+
+// Pointer stored at l: relocation target, else the stored address (linked files only).
+static struct loc read_ptr(const struct elf_file *f, struct loc l)
+{
+	struct reloc key = { .at = l } ;
+	const struct reloc *r = bsearch(&key, f->relocs, f->reloc_count, sizeof(*f->relocs), cmp_reloc) ;
+	if ( r ) return r->to ;
+	const uint64_t *p = data_at(f, l, sizeof(*p)) ;
+	if ( !f->linked || !p || !*p ) return (struct loc) { 0 } ;
+	return loc_of_addr(f, *p) ;
+}
+
+// Pointer field of the header at hdr, sec 0 if NULL.
+#define FIELD(f, hdr, field) read_ptr(f, (struct loc) { (hdr).sec, (hdr).off + offsetof(struct enum_desc, field) })
+
+static bool open_elf(struct elf_file *f, const char *path)
+{
+	*f = (struct elf_file) { .path = path } ;
+	int fd = open(path, O_RDONLY) ;
+	struct stat st ;
+	if ( fd < 0 || fstat(fd, &st) < 0 ) {
+		perror(path) ;
+		if ( fd >= 0 ) close(fd) ;
+		return false ;
+	}
+	f->size = st.st_size ;
+	f->map = f->size ? mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED ;
+	close(fd) ;
+	if ( f->map == MAP_FAILED ) {
+		fprintf(stderr, "%s: cannot map\n", path) ;
+		return false ;
+	}
+	f->eh = (const Elf64_Ehdr *) f->map ;
+	if ( f->size < sizeof(*f->eh) || memcmp(f->eh->e_ident, ELFMAG, SELFMAG)
+			|| f->eh->e_ident[EI_CLASS] != ELFCLASS64 || f->eh->e_ident[EI_DATA] != ELFDATA2LSB
+			|| f->eh->e_shoff + (uint64_t) f->eh->e_shnum * sizeof(Elf64_Shdr) > f->size ) {
+		fprintf(stderr, "%s: not a 64 bit little endian ELF file\n", path) ;
+		munmap((void *) f->map, f->size) ;
+		return false ;
+	}
+	f->sh = (const Elf64_Shdr *) (f->map + f->eh->e_shoff) ;
+	f->shnum = f->eh->e_shnum ;
+	f->linked = f->eh->e_type == ET_EXEC || f->eh->e_type == ET_DYN ;
+	load_relocs(f) ;
+	return true ;
+}
+
+static void close_elf(struct elf_file *f)
+{
+	free(f->relocs) ;
+	f->relocs = NULL ;
+}
+
+static uint64_t fnv1a(uint64_t h, const void *p, size_t n)
+{
+	for (size_t i=0 ; i<n ; i++) h = (h ^ ((const unsigned char *) p)[i]) * 1099511628211u ;
+	return h ;
+}
+
+struct line_set {
+	struct loc lines[32] ;
+	int n ;
+} ;
+
+// Lines are counted by section address, by offset for objects (sections start aligned).
+static void add_lines(struct line_set *set, const struct elf_file *f, struct loc l, size_t size)
+{
+	if ( !l.sec || !size ) return ;
+	uint64_t base = f->sh[l.sec].sh_addr + l.off ;
+	for (uint64_t line = base / LINE_SIZE ; line <= (base + size - 1) / LINE_SIZE ; line++) {
+		struct loc key = { f->linked ? 0 : l.sec, line } ;
+		int k = 0 ;
+		while ( k < set->n && cmp_loc(set->lines[k], key) ) k++ ;
+		if ( k == set->n && set->n < 32 ) set->lines[set->n++] = key ;
+	}
+}
+
+static void add_has(struct desc_info *d, const char *what)
+{
+	size_t len = strlen(d->has) ;
+	snprintf(d->has + len, sizeof(d->has) - len, "%s%s", len ? "," : "", what) ;
+}
+
+// Same choice as enum_refl_build makes for the value index, plus the scan for small enums.
+static const char *suggest_lookup(int count, enum_desc_val min, enum_desc_val max)
+{
+	if ( count <= 8 ) return "scan" ;
+	uint64_t words = ((uint64_t) max - min) / 32 + 1 ;
+	return words <= ENUM_DESC_BITMAP_WORDS_MAX((uint64_t) count) ? "bitmap" : "sorted" ;
+}
+
+static int cmp_val(const void *a, const void *b)
+{
+	enum_desc_val x = *(const enum_desc_val *) a, y = *(const enum_desc_val *) b ;
+	return x < y ? -1 : x > y ;
+}
+
+// Bytes of a label blob (name, labels, up to 8 NUL of padding), 0 if a label is unreadable.
+static size_t strs_extent(const struct elf_file *f, struct loc strs_loc, const uint16_t *lbl_off, int count, uint64_t *hash)
+{
+	const char *strs = str_at(f, strs_loc) ;
+	if ( !strs ) return 0 ;
+	size_t strs_len = strlen(strs)+1 ;
+	for (int i=0 ; lbl_off && i<count ; i++) {
+		const char *label = str_at(f, (struct loc) { strs_loc.sec, strs_loc.off + lbl_off[i] }) ;
+		if ( !label ) return 0 ;
+		*hash = fnv1a(*hash, label, strlen(label)+1) ;
+		if ( lbl_off[i] + strlen(label)+1 > strs_len ) strs_len = lbl_off[i] + strlen(label)+1 ;
+	}
+	for (int pad=0 ; pad<8 && data_at(f, (struct loc) { strs_loc.sec, strs_loc.off + strs_len }, 1) && !strs[strs_len] ; pad++) strs_len++ ;
+	return strs_len ;
+}
+
+// Trie and its arrays. Edges have their own blob when labels are kept only in the trie.
+static size_t trie_bytes(const struct elf_file *f, struct loc trie_loc, struct loc strs_loc, int count, uint64_t *hash)
+{
+	const struct enum_desc_trie *trie = data_at(f, trie_loc, sizeof(*trie)) ;
+	if ( !trie ) return 0 ;
+	int nodes = trie->node_count ;
+	size_t bytes = sizeof(*trie) + nodes * (sizeof(uint32_t) + 3*sizeof(uint16_t) + sizeof(enum_desc_idx))
+		+ sizeof(uint16_t) + count * sizeof(uint16_t) ;
+	struct loc segs_loc = read_ptr(f, (struct loc) { trie_loc.sec, trie_loc.off + offsetof(struct enum_desc_trie, segs) }) ;
+	struct loc len_loc = read_ptr(f, (struct loc) { trie_loc.sec, trie_loc.off + offsetof(struct enum_desc_trie, seg_len) }) ;
+	const uint16_t *seg_len = data_at(f, len_loc, nodes * sizeof(*seg_len)) ;
+	if ( cmp_loc(segs_loc, strs_loc) && seg_len ) {
+		size_t segs_len = 0 ;
+		for (int n=0 ; n<nodes ; n++) segs_len += seg_len[n] ;
+		const char *segs = data_at(f, segs_loc, segs_len) ;
+		if ( segs ) *hash = fnv1a(*hash, segs, segs_len) ;
+		bytes += segs_len ;
+	}
+	return bytes ;
+}
+
+static bool decode_desc(const struct elf_file *f, struct loc hdr_loc, struct desc_info *d)
+{
+	const struct enum_desc *hdr = data_at(f, hdr_loc, sizeof(*hdr)) ;
+	if ( !hdr ) return false ;
+	int count = hdr->value_count ;
+	struct loc vals_loc = FIELD(f, hdr_loc, values) ;
+	struct loc off_loc = FIELD(f, hdr_loc, lbl_off) ;
+	struct loc strs_loc = FIELD(f, hdr_loc, strs) ;
+	const enum_desc_val *vals = data_at(f, vals_loc, count * sizeof(*vals)) ;
+	const uint16_t *lbl_off = data_at(f, off_loc, count * sizeof(*lbl_off)) ;
+	const char *strs = strs_loc.sec ? str_at(f, strs_loc) : NULL ;
+	if ( !strs || (count && !vals) || (count && !lbl_off && !(hdr->flags & ENUM_DESC_F_TRIE_LABELS)) ) return false ;
+
+	*d = (struct desc_info) { .file = f->path, .name = strs, .count = count } ;
+	d->hash = fnv1a(1469598103934665603u, strs, strlen(strs)+1) ;
+	d->hash = fnv1a(d->hash, vals, count * sizeof(*vals)) ;
+
+	size_t strs_len = strs_extent(f, strs_loc, lbl_off, count, &d->hash) ;
+	if ( !strs_len ) return false ;
+
+	enum_desc_val *sorted = calloc(count+1, sizeof(*sorted)) ;
+	if ( count ) memcpy(sorted, vals, count * sizeof(*vals)) ;
+	qsort(sorted, count, sizeof(*sorted), cmp_val) ;
+	for (int i=0 ; i<count ; i++) d->uniq += !i || sorted[i] != sorted[i-1] ;
+	d->min = count ? sorted[0] : 0 ;
+	d->max = count ? sorted[count-1] : 0 ;
+	free(sorted) ;
+	d->lookup = suggest_lookup(count, d->min, d->max) ;
+
+	size_t bytes = sizeof(*hdr) + count * sizeof(*vals) + (lbl_off ? count * sizeof(*lbl_off) : 0) + strs_len ;
+	struct line_set lines = { .n = 0 } ;
+	add_lines(&lines, f, hdr_loc, sizeof(*hdr)) ;
+	add_lines(&lines, f, vals_loc, count * sizeof(*vals)) ;
+	if ( lbl_off ) add_lines(&lines, f, off_loc, count * sizeof(*lbl_off)) ;
+	add_lines(&lines, f, strs_loc, strs_len) ;
+	d->lines = lines.n ;
+
+	if ( FIELD(f, hdr_loc, value_bits).sec && (hdr->flags & ENUM_DESC_F_RANGE) ) {
+		size_t words = ((uint64_t) hdr->value_max - hdr->value_min) / 32 + 1 ;
+		bytes += words * sizeof(uint32_t) ;
+		if ( FIELD(f, hdr_loc, value_rank).sec ) bytes += words * sizeof(uint16_t) ;
+		add_has(d, "bitmap") ;
+	}
+	if ( FIELD(f, hdr_loc, by_value).sec ) {
+		bytes += hdr->uniq_count * sizeof(enum_desc_idx) ;
+		add_has(d, "sorted") ;
+	}
+	if ( FIELD(f, hdr_loc, alias_next).sec ) bytes += count * sizeof(enum_desc_idx) ;
+	if ( FIELD(f, hdr_loc, lbl_blk).sec && lbl_off && count ) bytes += ((lbl_off[count-1] >> 3) + 1) * sizeof(enum_desc_idx) ;
+	size_t tb = trie_bytes(f, FIELD(f, hdr_loc, trie), strs_loc, count, &d->hash) ;
+	if ( tb ) {
+		bytes += tb ;
+		add_has(d, "trie") ;
+	}
+	// Extra label sets: same layout as the primary labels.
+	struct loc sets_loc = FIELD(f, hdr_loc, label_sets) ;
+	for (int k=0 ; sets_loc.sec && k<hdr->label_set_count ; k++) {
+		struct loc set_loc = { sets_loc.sec, sets_loc.off + k * sizeof(struct enum_desc_label_set) } ;
+		struct loc set_strs = read_ptr(f, (struct loc) { set_loc.sec, set_loc.off + offsetof(struct enum_desc_label_set, strs) }) ;
+		struct loc set_off = read_ptr(f, (struct loc) { set_loc.sec, set_loc.off + offsetof(struct enum_desc_label_set, lbl_off) }) ;
+		struct loc set_trie = read_ptr(f, (struct loc) { set_loc.sec, set_loc.off + offsetof(struct enum_desc_label_set, trie) }) ;
+		const uint16_t *offs = data_at(f, set_off, count * sizeof(*offs)) ;
+		size_t set_len = set_strs.sec && offs ? strs_extent(f, set_strs, offs, count, &d->hash) : 0 ;
+		if ( !set_len ) return false ;
+		bytes += sizeof(struct enum_desc_label_set) + count * sizeof(*offs) + set_len + trie_bytes(f, set_trie, set_strs, count, &d->hash) ;
+	}
+	if ( hdr->label_set_count && sets_loc.sec ) {
+		char sets[16] ;
+		snprintf(sets, sizeof(sets), "sets%d", hdr->label_set_count) ;
+		add_has(d, sets) ;
+	}
+	d->bytes = bytes ;
+	if ( !d->has[0] ) add_has(d, "scan") ;
+	return true ;
+}
+
+static int scan_file(const char *path, struct desc_info **descs, int *ndescs, int *cap)
+{
+	struct elf_file f ;
+	if ( !open_elf(&f, path) ) return -1 ;
+	int found = 0 ;
+	size_t total = 0 ;
+	for (int s=1 ; s<f.shnum ; s++) {
+		const Elf64_Shdr *sh = &f.sh[s] ;
+		if ( sh->sh_type != SHT_SYMTAB || sh->sh_link >= (unsigned) f.shnum ) continue ;
+		const Elf64_Sym *syms = data_at(&f, (struct loc) { s, 0 }, sh->sh_size) ;
+		const Elf64_Shdr *strsh = &f.sh[sh->sh_link] ;
+		const char *names = data_at(&f, (struct loc) { sh->sh_link, 0 }, strsh->sh_size) ;
+		if ( !syms || !names ) continue ;
+		for (size_t k=1 ; k < sh->sh_size / sizeof(*syms) ; k++) {
+			const Elf64_Sym *sym = &syms[k] ;
+			if ( sym->st_name >= strsh->sh_size || ELF64_ST_TYPE(sym->st_info) != STT_OBJECT ) continue ;
+			if ( sym->st_shndx == SHN_UNDEF || sym->st_shndx >= SHN_LORESERVE ) continue ;
+			if ( strncmp(names + sym->st_name, DESC_SYM_PREFIX, strlen(DESC_SYM_PREFIX)) ) continue ;
+			struct loc hdr_loc = f.linked ? loc_of_addr(&f, sym->st_value) : (struct loc) { sym->st_shndx, sym->st_value } ;
+			if ( *ndescs == *cap ) {
+				*cap = *cap ? 2 * *cap : 64 ;
+				*descs = realloc(*descs, *cap * sizeof(**descs)) ;
+			}
+			struct desc_info *d = &(*descs)[*ndescs] ;
+			if ( !decode_desc(&f, hdr_loc, d) ) {
+				fprintf(stderr, "%s: %s: cannot decode\n", path, names + sym->st_name) ;
+				continue ;
+			}
+			printf("%s: %s items=%d uniq=%d range=%d..%d bytes=%zu lines=%d has=%s lookup=%s\n", path, d->name,
+				d->count, d->uniq, d->min, d->max, d->bytes, d->lines, d->has, d->lookup) ;
+			(*ndescs)++ ;
+			found++ ;
+			total += d->bytes ;
+		}
+	}
+	printf("%s: %d descriptors, %zu bytes\n", path, found, total) ;
+	close_elf(&f) ;     // names point into the mapping, kept until exit
+	return found ;
+}
+
+static int cmp_desc_name(const void *a, const void *b)
+{
+	const struct desc_info *x = a, *y = b ;
+	int c = strcmp(x->name, y->name) ;
+	if ( c ) return c ;
+	return x < y ? -1 : x > y ;
+}
+
+int main(int argc, char **argv)
+{
+	if ( argc < 2 ) {
+		fprintf(stderr, "usage: %s elf-file...\n", argv[0]) ;
+		return 2 ;
+	}
+	struct desc_info *descs = NULL ;
+	int ndescs = 0, cap = 0, status = 0 ;
+	for (int i=1 ; i<argc ; i++) {
+		if ( scan_file(argv[i], &descs, &ndescs, &cap) < 0 ) status = 1 ;
+	}
+
+	// Same enum name more than once: identical copies are wasted bytes, different ones a conflict.
+	qsort(descs, ndescs, sizeof(*descs), cmp_desc_name) ;
+	size_t wasted = 0 ;
+	for (int a=0, b ; a<ndescs ; a=b) {
+		bool same = true ;
+		for (b=a+1 ; b<ndescs && !strcmp(descs[a].name, descs[b].name) ; b++) same = same && descs[b].hash == descs[a].hash ;
+		if ( b - a < 2 ) continue ;
+		printf("duplicate: %s x%d %s:", descs[a].name, b - a, same ? "identical" : "different") ;
+		for (int k=a ; k<b ; k++) printf(" %s", descs[k].file) ;
+		printf("\n") ;
+		if ( same ) wasted += (b - a - 1) * descs[a].bytes ;
+	}
+	printf("total: %d descriptors, %zu bytes in duplicates\n", ndescs, wasted) ;
+	free(descs) ;
+	return status ;
+}
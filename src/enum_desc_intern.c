@@ -0,0 +1,181 @@
+#include "enum_desc_impl.h"
+#include "enum_refl.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+//--------------------------------------------------------------------------------
+// Interned descriptors, shared by content (name, values, labels, meta, ext).
+// Readers walk the bucket chains without a lock and take a reference with a CAS
+// that never revives a zero count, the descriptor is only read under a reference.
+// Insert and the last release hold the lock. Nodes stay linked for the life of the
+// process: a node whose descriptor was freed is reused by a later insert into the
+// same bucket, so a reader never follows a freed node.
+//--------------------------------------------------------------------------------
+
+#define INTERN_BUCKETS 1024             // power of 2
+
+struct intern_node {
+	_Atomic(struct intern_node *) next ;
+	atomic_uint hash ;
+	atomic_int refs ;                   // 0: free, or being released
+	_Atomic(enum_desc_t) ed ;           // NULL once released
+	enum_desc_ext_t ext ;               // as passed to enum_refl_build_interned
+} ;
+
+static _Atomic(struct intern_node *) buckets[INTERN_BUCKETS] ;
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER ;
+static atomic_size_t intern_live, intern_hits ;
+
+// Content fingerprint (labels and values, stored in the descriptor) mixed with the meta
+// pointers, so release finds the node without rebuilding trie-only labels.
+static uint64_t mix_meta(uint64_t h, const void *meta)
+{
+	return (h ^ (uintptr_t) meta) * UINT64_C(1099511628211) ;
+}
+
+static uint32_t fold(uint64_t h)
+{
+	return (uint32_t) (h ^ (h >> 32)) ;
+}
+
+static uint32_t hash_entries(const char *name, const struct enum_desc_entry entries[], int count)
+{
+	uint64_t h = enum_desc_fingerprint_of(name, entries, count) ;
+	for (int i=0 ; i<count ; i++) h = mix_meta(h, entries[i].meta) ;
+	return fold(h) ;
+}
+
+static uint32_t hash_desc(enum_desc_t ed)
+{
+	uint64_t h = ed->fingerprint ;
+	for (int i=0 ; i<ed->value_count ; i++) h = mix_meta(h, enum_desc_meta_at(ed, i)) ;
+	return fold(h) ;
+}
+
+static bool same_desc(enum_desc_t ed, const char *name, const struct enum_desc_entry entries[], int count)
+{
+	if ( ed->value_count != count || strcmp(enum_desc_name(ed), name) ) return false ;
+	for (int i=0 ; i<count ; i++) {
+		if ( ed->values[i] != entries[i].value || enum_desc_meta_at(ed, i) != entries[i].meta ) return false ;
+		if ( strcmp(enum_desc_label_at(ed, i), entries[i].name) ) return false ;
+	}
+	return true ;
+}
+
+static bool try_ref(struct intern_node *node)
+{
+	int n = atomic_load_explicit(&node->refs, memory_order_relaxed) ;
+	while ( n > 0 ) {
+		if ( atomic_compare_exchange_weak_explicit(&node->refs, &n, n+1, memory_order_acquire, memory_order_relaxed) ) return true ;
+	}
+	return false ;
+}
+
+static void release_node(struct intern_node *node)
+{
+	if ( atomic_fetch_sub_explicit(&node->refs, 1, memory_order_acq_rel) != 1 ) return ;
+	// Count is 0 for good: nobody can take a reference, insert only reuses nodes with no ed.
+	pthread_mutex_lock(&intern_lock) ;
+	struct enum_desc *ed = (struct enum_desc *) atomic_load_explicit(&node->ed, memory_order_relaxed) ;
+	atomic_store_explicit(&node->ed, NULL, memory_order_relaxed) ;
+	pthread_mutex_unlock(&intern_lock) ;
+	ed->flags &= ~ENUM_DESC_F_INTERNED ;
+	enum_desc_destroy(ed) ;
+	atomic_fetch_sub_explicit(&intern_live, 1, memory_order_relaxed) ;
+}
+
+static _Atomic(struct intern_node *) *bucket_of(uint32_t h)
+{
+	return &buckets[h & (INTERN_BUCKETS-1)] ;
+}
+
+// Lock free: a referenced descriptor with this content, or NULL.
+static enum_desc_t lookup(uint32_t h, const char *name, const struct enum_desc_entry entries[], int count, enum_desc_ext_t ext)
+{
+	for (struct intern_node *node = atomic_load_explicit(bucket_of(h), memory_order_acquire) ; node ;
+			node = atomic_load_explicit(&node->next, memory_order_acquire)) {
+		if ( atomic_load_explicit(&node->hash, memory_order_relaxed) != h || !try_ref(node) ) continue ;
+		// The node may have been reused since the hash was read, compare under the reference.
+		enum_desc_t ed = atomic_load_explicit(&node->ed, memory_order_relaxed) ;
+		if ( node->ext == ext && same_desc(ed, name, entries, count) ) return ed ;
+		release_node(node) ;
+	}
+	return NULL ;
+}
+
+// With the lock held: descriptors can not be freed, compare before taking a reference.
+static enum_desc_t lookup_locked(uint32_t h, const char *name, const struct enum_desc_entry entries[], int count, enum_desc_ext_t ext,
+	struct intern_node **free_node)
+{
+	*free_node = NULL ;
+	for (struct intern_node *node = atomic_load_explicit(bucket_of(h), memory_order_relaxed) ; node ;
+			node = atomic_load_explicit(&node->next, memory_order_relaxed)) {
+		enum_desc_t ed = atomic_load_explicit(&node->ed, memory_order_relaxed) ;
+		if ( !ed ) {
+			if ( atomic_load_explicit(&node->refs, memory_order_relaxed) == 0 ) *free_node = node ;
+			continue ;
+		}
+		if ( atomic_load_explicit(&node->hash, memory_order_relaxed) == h && node->ext == ext
+				&& same_desc(ed, name, entries, count) && try_ref(node) ) return ed ;
+	}
+	return NULL ;
+}
+
+enum_desc_t enum_refl_build_interned(const char *name, struct enum_desc_entry entries[], enum_desc_ext_t ext)
+{
+	int count = 0 ;
+	while ( entries[count].name ) count++ ;
+	uint32_t h = hash_entries(name, entries, count) ;
+	enum_desc_t ed = lookup(h, name, entries, count, ext) ;
+	if ( ed ) {
+		atomic_fetch_add_explicit(&intern_hits, 1, memory_order_relaxed) ;
+		return ed ;
+	}
+
+	// Built without ext: a duplicate that loses the insert race is freed without calling
+	// ext->destroy, which would release state the interned descriptor shares.
+	struct enum_desc *built = (struct enum_desc *) enum_refl_build(name, entries, NULL) ;
+	struct intern_node *node ;
+	pthread_mutex_lock(&intern_lock) ;
+	ed = lookup_locked(h, name, entries, count, ext, &node) ;
+	if ( ed ) {
+		// Another thread inserted it meanwhile.
+		pthread_mutex_unlock(&intern_lock) ;
+		enum_desc_destroy(built) ;
+		atomic_fetch_add_explicit(&intern_hits, 1, memory_order_relaxed) ;
+		return ed ;
+	}
+	built->flags |= ENUM_DESC_F_INTERNED ;
+	if ( ext ) built->ext = ext ;
+	bool fresh = node == NULL ;
+	if ( fresh ) node = calloc(1, sizeof(*node)) ;
+	atomic_store_explicit(&node->hash, h, memory_order_relaxed) ;
+	atomic_store_explicit(&node->ed, built, memory_order_relaxed) ;
+	node->ext = ext ;
+	atomic_store_explicit(&node->refs, 1, memory_order_release) ;
+	if ( fresh ) {
+		atomic_store_explicit(&node->next, atomic_load_explicit(bucket_of(h), memory_order_relaxed), memory_order_relaxed) ;
+		atomic_store_explicit(bucket_of(h), node, memory_order_release) ;
+	}
+	pthread_mutex_unlock(&intern_lock) ;
+	atomic_fetch_add_explicit(&intern_live, 1, memory_order_relaxed) ;
+	return built ;
+}
+
+// From enum_desc_destroy: drop the caller's reference, which keeps the node's ed stable.
+void enum_desc_intern_release(enum_desc_t ed)
+{
+	for (struct intern_node *node = atomic_load_explicit(bucket_of(hash_desc(ed)), memory_order_acquire) ; node ;
+			node = atomic_load_explicit(&node->next, memory_order_acquire)) {
+		if ( atomic_load_explicit(&node->ed, memory_order_relaxed) == ed ) {
+			release_node(node) ;
+			return ;
+		}
+	}
+}
+
+void enum_refl_intern_stats(size_t *live, size_t *hits)
+{
+	if ( live ) *live = atomic_load_explicit(&intern_live, memory_order_relaxed) ;
+	if ( hits ) *hits = atomic_load_explicit(&intern_hits, memory_order_relaxed) ;
+}
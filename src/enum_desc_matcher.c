@@ -0,0 +1,100 @@
+#include "enum_desc_impl.h"
+
+//--------------------------------------------------------------------------------
+// Resumable label matcher. With a trie, each byte is one step along an edge or one
+// child lookup. Without, the lowest candidate label is kept: it holds the bytes fed
+// so far, so later candidates are checked against it instead of a copy of the input.
+//--------------------------------------------------------------------------------
+
+static enum enum_desc_match_state trie_state(struct enum_desc_matcher *m)
+{
+	const struct enum_desc_trie *trie = m->ed->trie ;
+	if ( m->edge_pos < trie->seg_len[m->node] ) {
+		m->term = ENUM_DESC_NOT_FOUND ;
+		return ENUM_DESC_MATCH_NEED_MORE ;
+	}
+	m->term = trie->term[m->node] ;
+	bool more = trie->child[m->node+1] > trie->child[m->node] ;
+	if ( m->term == ENUM_DESC_NOT_FOUND ) return ENUM_DESC_MATCH_NEED_MORE ;
+	return more ? ENUM_DESC_MATCH_PREFIX : ENUM_DESC_MATCH_FULL ;
+}
+
+static enum enum_desc_match_state trie_feed(struct enum_desc_matcher *m, unsigned char c)
+{
+	const struct enum_desc_trie *trie = m->ed->trie ;
+	if ( m->edge_pos < trie->seg_len[m->node] ) {
+		if ( (unsigned char) trie->segs[trie->seg_off[m->node] + m->edge_pos] != c ) return ENUM_DESC_MATCH_REJECT ;
+		m->edge_pos++ ;
+	} else {
+		int next = enum_desc_trie_child(trie, m->node, c) ;
+		if ( next < 0 ) return ENUM_DESC_MATCH_REJECT ;
+		m->node = next ;
+		m->edge_pos = 1 ;
+	}
+	return trie_state(m) ;
+}
+
+// First label from idx on that starts with prefix[0..len) followed by c (0: ends there).
+static enum_desc_idx scan_next(enum_desc_t ed, enum_desc_idx idx, const char *prefix, size_t len, char c)
+{
+	for (int i=idx ; i<ed->value_count ; i++) {
+		const char *label = enum_desc_label_at(ed, i) ;
+		if ( !strncmp(label, prefix, len) && label[len] == c ) return i ;
+	}
+	return ENUM_DESC_NOT_FOUND ;
+}
+
+static enum enum_desc_match_state scan_state(struct enum_desc_matcher *m)
+{
+	const char *prefix = enum_desc_label_at(m->ed, m->cand) ;
+	m->term = scan_next(m->ed, m->cand, prefix, m->len, 0) ;
+	bool more = false ;
+	for (int i=m->cand ; i<m->ed->value_count && !more ; i++) {
+		const char *label = enum_desc_label_at(m->ed, i) ;
+		more = !strncmp(label, prefix, m->len) && label[m->len] ;
+	}
+	if ( m->term == ENUM_DESC_NOT_FOUND ) return ENUM_DESC_MATCH_NEED_MORE ;
+	return more ? ENUM_DESC_MATCH_PREFIX : ENUM_DESC_MATCH_FULL ;
+}
+
+static enum enum_desc_match_state scan_feed(struct enum_desc_matcher *m, char c)
+{
+	if ( !c ) return ENUM_DESC_MATCH_REJECT ;
+	const char *prefix = enum_desc_label_at(m->ed, m->cand) ;
+	enum_desc_idx next = scan_next(m->ed, m->cand, prefix, m->len, c) ;
+	if ( next == ENUM_DESC_NOT_FOUND ) return ENUM_DESC_MATCH_REJECT ;
+	m->cand = next ;
+	m->len++ ;
+	return scan_state(m) ;
+}
+
+void enum_desc_matcher_init(struct enum_desc_matcher *m, enum_desc_t ed)
+{
+	*m = (struct enum_desc_matcher) { .ed = ed, .cand = 0, .term = ENUM_DESC_NOT_FOUND } ;
+	if ( ed->trie ) {
+		m->state = trie_state(m) ;
+	} else if ( ed->value_count ) {
+		m->state = scan_state(m) ;
+	} else {
+		m->state = ENUM_DESC_MATCH_REJECT ;
+	}
+}
+
+enum enum_desc_match_state enum_desc_matcher_feed(struct enum_desc_matcher *m, const char *buf, size_t len)
+{
+	for (size_t i=0 ; i<len && m->state != ENUM_DESC_MATCH_REJECT ; i++) {
+		if ( m->ed->trie ) {
+			m->state = trie_feed(m, buf[i]) ;
+			if ( m->state != ENUM_DESC_MATCH_REJECT ) m->len++ ;
+		} else {
+			m->state = scan_feed(m, buf[i]) ;
+		}
+		if ( m->state == ENUM_DESC_MATCH_REJECT ) m->term = ENUM_DESC_NOT_FOUND ;
+	}
+	return m->state ;
+}
+
+enum_desc_idx enum_desc_matcher_finish(const struct enum_desc_matcher *m)
+{
+	return m->state == ENUM_DESC_MATCH_REJECT ? ENUM_DESC_NOT_FOUND : m->term ;
+}
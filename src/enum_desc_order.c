@@ -0,0 +1,94 @@
+#include "enum_desc_impl.h"
+
+//--------------------------------------------------------------------------------
+// Sorted iteration and value ranges. Value order is by_value, each distinct value
+// followed by its aliases (alias_next). Label order is by_label. Descriptors without
+// these indexes (hand-written) fall back to a scan for the next item, O(n) per step.
+//--------------------------------------------------------------------------------
+
+// Smallest (value, index) after (values[cur], cur), first item when cur is -1.
+static enum_desc_idx scan_next_value(enum_desc_t ed, enum_desc_idx cur)
+{
+	enum_desc_idx best = ENUM_DESC_NOT_FOUND ;
+	for (int i=0 ; i<ed->value_count ; i++) {
+		enum_desc_val v = ed->values[i] ;
+		if ( cur >= 0 && (v < ed->values[cur] || (v == ed->values[cur] && i <= cur)) ) continue ;
+		if ( best < 0 || v < ed->values[best] ) best = i ;
+	}
+	return best ;
+}
+
+// Same with (label, index).
+static enum_desc_idx scan_next_label(enum_desc_t ed, enum_desc_idx cur)
+{
+	enum_desc_idx best = ENUM_DESC_NOT_FOUND ;
+	const char *cur_label = cur >= 0 ? enum_desc_label_at(ed, cur) : NULL ;
+	const char *best_label = NULL ;
+	for (int i=0 ; i<ed->value_count ; i++) {
+		const char *label = enum_desc_label_at(ed, i) ;
+		if ( cur_label ) {
+			int c = strcmp(label, cur_label) ;
+			if ( c < 0 || (c == 0 && i <= cur) ) continue ;
+		}
+		if ( best < 0 || strcmp(label, best_label) < 0 ) {
+			best = i ;
+			best_label = label ;
+		}
+	}
+	return best ;
+}
+
+void enum_desc_iter_sorted(enum_desc_t ed, enum enum_desc_order order, struct enum_desc_iter *it)
+{
+	*it = (struct enum_desc_iter) { .ed = ed, .order = order, .pos = 0, .cur = ENUM_DESC_NOT_FOUND } ;
+}
+
+enum_desc_idx enum_desc_iter_next(struct enum_desc_iter *it)
+{
+	enum_desc_t ed = it->ed ;
+	enum_desc_idx idx = ENUM_DESC_NOT_FOUND ;
+	switch ( it->order ) {
+	case ENUM_DESC_ORDER_VALUE:
+		if ( !ed->by_value ) idx = scan_next_value(ed, it->cur) ;
+		else if ( it->cur >= 0 && ed->alias_next && ed->alias_next[it->cur] >= 0 ) idx = ed->alias_next[it->cur] ;
+		else if ( it->pos < ed->uniq_count ) idx = ed->by_value[it->pos++] ;
+		break ;
+	case ENUM_DESC_ORDER_LABEL:
+		if ( !ed->by_label ) idx = scan_next_label(ed, it->cur) ;
+		else if ( it->pos < ed->value_count ) idx = ed->by_label[it->pos++] ;
+		break ;
+	default:
+		if ( it->pos < ed->value_count ) idx = it->pos++ ;
+		break ;
+	}
+	if ( idx >= 0 ) it->cur = idx ;
+	return idx ;
+}
+
+// Binary search for the first distinct value >= lo, then walk: O(log n + k).
+int enum_desc_range(enum_desc_t ed, enum_desc_val lo, enum_desc_val hi, enum_desc_idx *idx_out, int max)
+{
+	int n = 0 ;
+	if ( lo > hi ) return 0 ;
+	if ( (ed->flags & ENUM_DESC_F_RANGE) && (hi < ed->value_min || lo > ed->value_max) ) return 0 ;
+	if ( !ed->by_value ) {
+		for (enum_desc_idx i = scan_next_value(ed, ENUM_DESC_NOT_FOUND) ; i >= 0 && ed->values[i] <= hi ; i = scan_next_value(ed, i)) {
+			if ( ed->values[i] < lo ) continue ;
+			if ( n < max ) idx_out[n] = i ;
+			n++ ;
+		}
+		return n ;
+	}
+	int first = 0, last = ed->uniq_count ;
+	while ( first < last ) {
+		int mid = (first + last) / 2 ;
+		if ( ed->values[ed->by_value[mid]] < lo ) first = mid + 1 ; else last = mid ;
+	}
+	for (int p=first ; p<ed->uniq_count && ed->values[ed->by_value[p]] <= hi ; p++) {
+		for (enum_desc_idx i = ed->by_value[p] ; i >= 0 ; i = ed->alias_next ? ed->alias_next[i] : ENUM_DESC_NOT_FOUND) {
+			if ( n < max ) idx_out[n] = i ;
+			n++ ;
+		}
+	}
+	return n ;
+}
@@ -0,0 +1,217 @@
+#include "enum_desc_remap.h"
+#include "enum_desc_def.h"
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_AVX2_DISPATCH 1
+#endif
+
+// Dense table when the old values span at most this many slots.
+#define REMAP_DENSE_MAX(count) (4 * (count) + 64)
+
+struct enum_desc_remap {
+	struct enum_desc_remap_report report ;
+	enum_desc_t old_ed, new_ed ;        // for enum_desc_remap_print
+	bool keep ;                         // unknown values stay as they are
+	enum_desc_val default_value ;
+	int count ;                         // translated values
+	// dense: to[value - min], known bit set for translated values
+	enum_desc_val min ;
+	uint32_t span ;
+	uint32_t *known ;
+	enum_desc_val *to ;
+	// sorted: from[] ascending, to[] parallel
+	enum_desc_val *from ;
+} ;
+
+struct value_to {
+	enum_desc_val from, to ;
+} ;
+
+static int cmp_value_to(const void *a, const void *b)
+{
+	const struct value_to *x = a, *y = b ;
+	return x->from < y->from ? -1 : x->from > y->from ;
+}
+
+static enum_desc_idx find_rename(const struct enum_desc_remap_policy *policy, enum_desc_t new_ed, const char *label)
+{
+	if ( !policy || !policy->renames ) return ENUM_DESC_NOT_FOUND ;
+	for (const char *const *r = policy->renames ; r[0] && r[1] ; r += 2) {
+		if ( !strcmp(r[0], label) ) return enum_desc_find_by_label(new_ed, r[1]) ;
+	}
+	return ENUM_DESC_NOT_FOUND ;
+}
+
+enum_desc_remap_t enum_desc_remap_build(enum_desc_t old_ed, enum_desc_t new_ed, const struct enum_desc_remap_policy *policy)
+{
+	int n_old = enum_desc_value_count(old_ed), n_new = enum_desc_value_count(new_ed) ;
+	unsigned flags = policy ? policy->flags : 0 ;
+	struct enum_desc_remap *map = calloc(1, sizeof(*map)) ;
+	struct enum_desc_remap_pair *renamed = calloc(n_old+1, sizeof(*renamed)) ;
+	enum_desc_idx *dropped = calloc(n_old+1, sizeof(*dropped)) ;
+	enum_desc_idx *added = calloc(n_new+1, sizeof(*added)) ;
+	bool *hit = calloc(n_new+1, sizeof(*hit)) ;
+	struct value_to *pairs = calloc(n_old+1, sizeof(*pairs)) ;
+	struct enum_desc_remap_report *rep = &map->report ;
+
+	int np = 0 ;
+	for (int i=0 ; i<n_old ; i++) {
+		enum_desc_val v = enum_desc_value_at(old_ed, i) ;
+		if ( enum_desc_find_by_value(old_ed, v) != i ) continue ;      // alias, the first label decides
+		const char *label = enum_desc_label_at(old_ed, i) ;
+		enum_desc_idx j = enum_desc_find_by_label(new_ed, label) ;
+		if ( j != ENUM_DESC_NOT_FOUND ) {
+			rep->mapped++ ;
+		} else {
+			j = find_rename(policy, new_ed, label) ;
+			if ( j == ENUM_DESC_NOT_FOUND && (flags & ENUM_DESC_REMAP_BY_VALUE) ) j = enum_desc_find_by_value(new_ed, v) ;
+			if ( j == ENUM_DESC_NOT_FOUND ) {
+				dropped[rep->dropped_count++] = i ;
+				continue ;
+			}
+			renamed[rep->renamed_count++] = (struct enum_desc_remap_pair) { .old_idx = i, .new_idx = j } ;
+		}
+		hit[j] = true ;
+		pairs[np++] = (struct value_to) { .from = v, .to = enum_desc_value_at(new_ed, j) } ;
+	}
+	for (int j=0 ; j<n_new ; j++) {
+		if ( !hit[j] ) added[rep->added_count++] = j ;
+	}
+	free(hit) ;
+	rep->renamed = renamed ;
+	rep->dropped = dropped ;
+	rep->added = added ;
+
+	map->old_ed = old_ed ;
+	map->new_ed = new_ed ;
+	map->keep = !(flags & ENUM_DESC_REMAP_DEFAULT) ;
+	map->default_value = policy ? policy->default_value : 0 ;
+	map->count = np ;
+	qsort(pairs, np, sizeof(*pairs), cmp_value_to) ;
+	uint64_t span = np ? (uint64_t) pairs[np-1].from - pairs[0].from : 0 ;
+	rep->dense = np && span < REMAP_DENSE_MAX((uint64_t) np) ;
+	if ( rep->dense ) {
+		map->min = pairs[0].from ;
+		map->span = span ;
+		map->to = calloc(span+1, sizeof(*map->to)) ;
+		map->known = calloc(span/32+1, sizeof(*map->known)) ;
+		for (uint32_t off=0 ; off<=span ; off++)
+			map->to[off] = map->keep ? (enum_desc_val) ((uint32_t) map->min + off) : map->default_value ;
+		for (int k=0 ; k<np ; k++) {
+			uint32_t off = (uint32_t) pairs[k].from - (uint32_t) map->min ;
+			map->to[off] = pairs[k].to ;
+			map->known[off >> 5] |= 1u << (off & 31) ;
+		}
+	} else {
+		map->from = calloc(np+1, sizeof(*map->from)) ;
+		map->to = calloc(np+1, sizeof(*map->to)) ;
+		for (int k=0 ; k<np ; k++) {
+			map->from[k] = pairs[k].from ;
+			map->to[k] = pairs[k].to ;
+		}
+	}
+	free(pairs) ;
+	return map ;
+}
+
+void enum_desc_remap_destroy(enum_desc_remap_t map)
+{
+	if ( !map ) return ;
+	free((void *) map->report.renamed) ;
+	free((void *) map->report.dropped) ;
+	free((void *) map->report.added) ;
+	free(map->known) ;
+	free(map->to) ;
+	free(map->from) ;
+	free((void *) map) ;
+}
+
+const struct enum_desc_remap_report *enum_desc_remap_report(enum_desc_remap_t map)
+{
+	return &map->report ;
+}
+
+// Translated value, or the fallback. *known tells which.
+static inline enum_desc_val remap_one(enum_desc_remap_t map, enum_desc_val value, bool *known)
+{
+	if ( map->report.dense ) {
+		uint32_t off = (uint32_t) value - (uint32_t) map->min ;
+		if ( off <= map->span ) {
+			*known = (map->known[off >> 5] >> (off & 31)) & 1 ;
+			return map->to[off] ;
+		}
+	} else {
+		int lo = 0, hi = map->count ;
+		while ( lo < hi ) {
+			int mid = (lo + hi) / 2 ;
+			if ( map->from[mid] == value ) {
+				*known = true ;
+				return map->to[mid] ;
+			}
+			if ( map->from[mid] < value ) lo = mid + 1 ; else hi = mid ;
+		}
+	}
+	*known = false ;
+	return map->keep ? value : map->default_value ;
+}
+
+enum_desc_val enum_desc_remap_value(enum_desc_remap_t map, enum_desc_val value)
+{
+	bool known ;
+	return remap_one(map, value, &known) ;
+}
+
+#if HAVE_AVX2_DISPATCH
+// Dense table, 8 values per step: gather the new value and the known bit.
+__attribute__((target("avx2")))
+static size_t remap_dense_avx2(enum_desc_remap_t map, enum_desc_val *vals, size_t n, size_t *unknown)
+{
+	const int *to = (const int *) map->to ;
+	const int *known = (const int *) map->known ;
+	const __m256i vmin = _mm256_set1_epi32(map->min) ;
+	const __m256i vspan = _mm256_set1_epi32(map->span) ;
+	const __m256i vdefault = _mm256_set1_epi32(map->default_value) ;
+	const __m256i one = _mm256_set1_epi32(1) ;
+	const __m256i m31 = _mm256_set1_epi32(31) ;
+	size_t i = 0, miss = 0 ;
+	for ( ; i + 8 <= n ; i += 8 ) {
+		__m256i v = _mm256_loadu_si256((const __m256i *) (vals + i)) ;
+		__m256i off = _mm256_sub_epi32(v, vmin) ;
+		__m256i in = _mm256_cmpeq_epi32(_mm256_max_epu32(off, vspan), vspan) ;     // off <= span, unsigned
+		__m256i out = _mm256_mask_i32gather_epi32(map->keep ? v : vdefault, to, off, in, 4) ;
+		__m256i word = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), known, _mm256_srli_epi32(off, 5), in, 4) ;
+		__m256i bit = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(off, m31)), one) ;
+		miss += 8 - __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(bit, one)))) ;
+		_mm256_storeu_si256((__m256i *) (vals + i), out) ;
+	}
+	*unknown = miss ;
+	return i ;
+}
+#endif
+
+size_t enum_desc_remap_apply(enum_desc_remap_t map, enum_desc_val *vals, size_t n)
+{
+	size_t i = 0, unknown = 0 ;
+#if HAVE_AVX2_DISPATCH
+	if ( map->report.dense && __builtin_cpu_supports("avx2") ) i = remap_dense_avx2(map, vals, n, &unknown) ;
+#endif
+	for ( ; i<n ; i++ ) {
+		bool known ;
+		vals[i] = remap_one(map, vals[i], &known) ;
+		unknown += !known ;
+	}
+	return unknown ;
+}
+
+void enum_desc_remap_print(FILE *fp, enum_desc_remap_t map)
+{
+	const struct enum_desc_remap_report *rep = &map->report ;
+	fprintf(fp, "remap: mapped=%d renamed=%d dropped=%d added=%d %s\n", rep->mapped, rep->renamed_count,
+		rep->dropped_count, rep->added_count, rep->dense ? "dense" : "sorted") ;
+	for (int k=0 ; k<rep->renamed_count ; k++)
+		fprintf(fp, "  renamed: %s -> %s\n", enum_desc_label_at(map->old_ed, rep->renamed[k].old_idx), enum_desc_label_at(map->new_ed, rep->renamed[k].new_idx)) ;
+	for (int k=0 ; k<rep->dropped_count ; k++)
+		fprintf(fp, "  dropped: %s\n", enum_desc_label_at(map->old_ed, rep->dropped[k])) ;
+	for (int k=0 ; k<rep->added_count ; k++)
+		fprintf(fp, "  added: %s\n", enum_desc_label_at(map->new_ed, rep->added[k])) ;
+}
@@ -0,0 +1,241 @@
+#include "enum_desc_set.h"
+#include "enum_desc_def.h"
+#include <stdalign.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_AVX2_DISPATCH 1
+#endif
+
+//--------------------------------------------------------------------------------
+// Bitset over indexes, padded to whole 256 bit blocks so the block loops have no
+// tail. Bits past value_count stay 0: fill masks the last word and the set
+// operations can not create them.
+//--------------------------------------------------------------------------------
+
+#define SET_BLOCK_WORDS 4               // uint64_t per 256 bit block
+
+struct enum_desc_set {
+	enum_desc_t ed ;
+	int count ;                         // value_count
+	int words ;                         // multiple of SET_BLOCK_WORDS
+	alignas(32) uint64_t bits[] ;
+} ;
+
+enum set_op { SET_OR, SET_AND, SET_ANDNOT } ;
+
+enum_desc_set_t enum_desc_set_create(enum_desc_t ed)
+{
+	int count = enum_desc_value_count(ed) ;
+	int words = (count + 255) / 256 * SET_BLOCK_WORDS ;
+	size_t size = sizeof(struct enum_desc_set) + words * sizeof(uint64_t) ;
+	struct enum_desc_set *s = aligned_alloc(32, (size + 31) & ~(size_t) 31) ;
+	if ( !s ) return NULL ;
+	*s = (struct enum_desc_set) { .ed = ed, .count = count, .words = words } ;
+	memset(s->bits, 0, words * sizeof(uint64_t)) ;
+	return s ;
+}
+
+void enum_desc_set_destroy(enum_desc_set_t s)
+{
+	free(s) ;
+}
+
+enum_desc_t enum_desc_set_desc(enum_desc_set_t s)
+{
+	return s->ed ;
+}
+
+void enum_desc_set_clear(enum_desc_set_t s)
+{
+	memset(s->bits, 0, s->words * sizeof(uint64_t)) ;
+}
+
+void enum_desc_set_fill(enum_desc_set_t s)
+{
+	enum_desc_set_clear(s) ;
+	int full = s->count / 64 ;
+	memset(s->bits, 0xff, full * sizeof(uint64_t)) ;
+	if ( s->count % 64 ) s->bits[full] = (UINT64_C(1) << (s->count % 64)) - 1 ;
+}
+
+bool enum_desc_set_add_index(enum_desc_set_t s, enum_desc_idx idx)
+{
+	if ( idx < 0 || idx >= s->count ) return false ;
+	s->bits[idx >> 6] |= UINT64_C(1) << (idx & 63) ;
+	return true ;
+}
+
+bool enum_desc_set_remove_index(enum_desc_set_t s, enum_desc_idx idx)
+{
+	if ( idx < 0 || idx >= s->count ) return false ;
+	s->bits[idx >> 6] &= ~(UINT64_C(1) << (idx & 63)) ;
+	return true ;
+}
+
+bool enum_desc_set_has_index(enum_desc_set_t s, enum_desc_idx idx)
+{
+	if ( idx < 0 || idx >= s->count ) return false ;
+	return (s->bits[idx >> 6] >> (idx & 63)) & 1 ;
+}
+
+bool enum_desc_set_add(enum_desc_set_t s, enum_desc_val value)
+{
+	return enum_desc_set_add_index(s, enum_desc_find_by_value(s->ed, value)) ;
+}
+
+// Aliases: every index of the value, found through the alias chain.
+static enum_desc_idx next_alias(enum_desc_set_t s, enum_desc_idx idx)
+{
+	if ( !s->ed->alias_next ) return ENUM_DESC_NOT_FOUND ;
+	return s->ed->alias_next[idx] ;
+}
+
+bool enum_desc_set_remove(enum_desc_set_t s, enum_desc_val value)
+{
+	enum_desc_idx idx = enum_desc_find_by_value(s->ed, value) ;
+	if ( idx == ENUM_DESC_NOT_FOUND ) return false ;
+	for ( ; idx != ENUM_DESC_NOT_FOUND ; idx = next_alias(s, idx)) enum_desc_set_remove_index(s, idx) ;
+	return true ;
+}
+
+bool enum_desc_set_contains(enum_desc_set_t s, enum_desc_val value)
+{
+	for (enum_desc_idx idx = enum_desc_find_by_value(s->ed, value) ; idx != ENUM_DESC_NOT_FOUND ; idx = next_alias(s, idx))
+		if ( enum_desc_set_has_index(s, idx) ) return true ;
+	return false ;
+}
+
+static int popcount_words(const uint64_t *bits, int words)
+{
+	int n = 0 ;
+	for (int i=0 ; i<words ; i++) n += __builtin_popcountll(bits[i]) ;
+	return n ;
+}
+
+static void combine(uint64_t *dst, const uint64_t *a, const uint64_t *b, int words, enum set_op op)
+{
+	for (int i=0 ; i<words ; i++)
+		dst[i] = op == SET_OR ? a[i] | b[i] : op == SET_AND ? a[i] & b[i] : a[i] & ~b[i] ;
+}
+
+#if HAVE_AVX2_DISPATCH
+// Nibble lookup with vpshufb, byte counts summed per 64 bit lane by vpsadbw.
+__attribute__((target("avx2")))
+static int popcount_words_avx2(const uint64_t *bits, int words)
+{
+	const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4) ;
+	const __m256i low = _mm256_set1_epi8(0x0f) ;
+	__m256i acc = _mm256_setzero_si256() ;
+	for (int i=0 ; i<words ; i+=SET_BLOCK_WORDS) {
+		__m256i v = _mm256_load_si256((const __m256i *) (bits + i)) ;
+		__m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)) ;
+		__m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)) ;
+		acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256())) ;
+	}
+	return _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3) ;
+}
+
+__attribute__((target("avx2")))
+static void combine_avx2(uint64_t *dst, const uint64_t *a, const uint64_t *b, int words, enum set_op op)
+{
+	for (int i=0 ; i<words ; i+=SET_BLOCK_WORDS) {
+		__m256i va = _mm256_load_si256((const __m256i *) (a + i)) ;
+		__m256i vb = _mm256_load_si256((const __m256i *) (b + i)) ;
+		__m256i r = op == SET_OR ? _mm256_or_si256(va, vb) : op == SET_AND ? _mm256_and_si256(va, vb) : _mm256_andnot_si256(vb, va) ;
+		_mm256_store_si256((__m256i *) (dst + i), r) ;
+	}
+}
+#endif
+
+int enum_desc_set_count(enum_desc_set_t s)
+{
+#if HAVE_AVX2_DISPATCH
+	if ( __builtin_cpu_supports("avx2") ) return popcount_words_avx2(s->bits, s->words) ;
+#endif
+	return popcount_words(s->bits, s->words) ;
+}
+
+static bool set_op(enum_desc_set_t dst, enum_desc_set_t a, enum_desc_set_t b, enum set_op op)
+{
+	if ( a->ed != dst->ed || b->ed != dst->ed ) return false ;
+#if HAVE_AVX2_DISPATCH
+	if ( __builtin_cpu_supports("avx2") ) {
+		combine_avx2(dst->bits, a->bits, b->bits, dst->words, op) ;
+		return true ;
+	}
+#endif
+	combine(dst->bits, a->bits, b->bits, dst->words, op) ;
+	return true ;
+}
+
+bool enum_desc_set_union(enum_desc_set_t dst, enum_desc_set_t a, enum_desc_set_t b)
+{
+	return set_op(dst, a, b, SET_OR) ;
+}
+
+bool enum_desc_set_intersect(enum_desc_set_t dst, enum_desc_set_t a, enum_desc_set_t b)
+{
+	return set_op(dst, a, b, SET_AND) ;
+}
+
+bool enum_desc_set_difference(enum_desc_set_t dst, enum_desc_set_t a, enum_desc_set_t b)
+{
+	return set_op(dst, a, b, SET_ANDNOT) ;
+}
+
+bool enum_desc_set_equal(enum_desc_set_t a, enum_desc_set_t b)
+{
+	return a->ed == b->ed && !memcmp(a->bits, b->bits, a->words * sizeof(uint64_t)) ;
+}
+
+bool enum_desc_set_subset(enum_desc_set_t a, enum_desc_set_t b)
+{
+	if ( a->ed != b->ed ) return false ;
+	for (int i=0 ; i<a->words ; i++)
+		if ( a->bits[i] & ~b->bits[i] ) return false ;
+	return true ;
+}
+
+enum_desc_idx enum_desc_set_next(enum_desc_set_t s, enum_desc_idx idx)
+{
+	int pos = idx + 1 ;
+	if ( pos < 0 || pos >= s->count ) return ENUM_DESC_NOT_FOUND ;
+	int w = pos >> 6 ;
+	uint64_t word = s->bits[w] & (~UINT64_C(0) << (pos & 63)) ;
+	while ( !word ) {
+		if ( ++w >= s->words ) return ENUM_DESC_NOT_FOUND ;
+		word = s->bits[w] ;
+	}
+	return (w << 6) + __builtin_ctzll(word) ;
+}
+
+size_t enum_desc_set_format(enum_desc_set_t s, char sep, char *buf, size_t size)
+{
+	size_t len = 0 ;
+	ENUM_DESC_SET_FOREACH(s, idx) {
+		const char *label = enum_desc_label_at(s->ed, idx) ;
+		size_t n = strlen(label) ;
+		if ( len ) {
+			if ( len < size ) buf[len] = sep ;
+			len++ ;
+		}
+		if ( len < size ) memcpy(buf + len, label, len + n < size ? n : size - len) ;
+		len += n ;
+	}
+	if ( size ) buf[len < size ? len : size-1] = '\0' ;
+	return len ;
+}
+
+size_t enum_desc_set_parse(enum_desc_set_t s, char sep, const char *buf, size_t len)
+{
+	if ( len == (size_t) -1 ) len = strlen(buf) ;
+	size_t unknown = 0 ;
+	for (const char *p = buf, *end = buf + len ; p < end ; ) {
+		const char *q = memchr(p, sep, end - p) ;
+		if ( !q ) q = end ;
+		if ( q > p && !enum_desc_set_add_index(s, enum_desc_find_by_label_n(s->ed, p, q - p)) ) unknown++ ;
+		p = q + 1 ;
+	}
+	return unknown ;
+}
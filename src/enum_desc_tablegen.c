@@ -0,0 +1,817 @@
+// enum_desc_tablegen: static descriptors for toolchains that can not load the plugin.
+//
+//   enum_desc_tablegen [-o out.c] [-e enum]... [-l set[:transform]...]... [-m manifest]... [file.i | -]...
+//
+// Reads enums from preprocessed C (gcc -E / clang -E output) and from manifests, and
+// writes a C file defining, per enum E, the objects the plugin emits: __enum_pack_<E>
+// (header, values, label offsets, labels, value bitmap and rank, value index in one
+// 64 byte aligned object), the alias chain, label blocks, label order and label trie,
+// the public __enum_desc__<E> (see ENUM_DESC_EXTERN / ENUM_DESC_REF) and its registry
+// entry, plus __enum_lsets_<E> for -l. Tables come from enum_refl_build_sets, which
+// follows the plugin's rules.
+//
+// C input: named enums and typedef'd anonymous ones. Values may use integer and
+// character constants, earlier enumerators, casts and the usual operators.
+// Manifest: "enum <name>" starts an enum, then one "<LABEL> [value]" per line, the
+// value defaults to the previous one + 1. '#' starts a comment.
+// -e limits the output to the listed enums, in input order.
+// -l adds an extra label set to every enum, as the plugin's label-set= argument:
+// name:transform[+transform...], transforms strip-prefix, lower and upper.
+
+#include <ctype.h>
+
+#include "enum_desc_def.h"
+#include "enum_refl.h"
+
+struct enum_def {
+	char *name ;
+	int count, cap ;
+	struct enum_desc_entry *entries ;
+} ;
+
+static struct enum_def *g_enums ;
+static int g_enum_count, g_enum_cap ;
+
+// Enumerator constants seen so far, for later initializers.
+struct constant {
+	char *name ;
+	long long value ;
+} ;
+static struct constant *g_consts ;
+static int g_const_count, g_const_cap ;
+
+static const char *g_input ;            // current file, for messages
+
+static void die(const char *fmt, const char *arg)
+{
+	fprintf(stderr, "enum_desc_tablegen: %s: ", g_input) ;
+	fprintf(stderr, fmt, arg) ;
+	fprintf(stderr, "\n") ;
+	exit(1) ;
+}
+
+static void *grow(void *p, int *cap, int need, size_t size)
+{
+	if ( need <= *cap ) return p ;
+	*cap = *cap ? 2 * *cap : 16 ;
+	if ( *cap < need ) *cap = need ;
+	return realloc(p, *cap * size) ;
+}
+
+static struct enum_def *new_enum(const char *name)
+{
+	g_enums = grow(g_enums, &g_enum_cap, g_enum_count+1, sizeof(*g_enums)) ;
+	struct enum_def *e = &g_enums[g_enum_count++] ;
+	*e = (struct enum_def) { .name = strdup(name) } ;
+	return e ;
+}
+
+static void add_item(struct enum_def *e, const char *label, long long value)
+{
+	e->entries = grow(e->entries, &e->cap, e->count+2, sizeof(*e->entries)) ;
+	e->entries[e->count++] = (struct enum_desc_entry) { .value = (enum_desc_val) value, .name = strdup(label) } ;
+	e->entries[e->count] = (struct enum_desc_entry) { 0 } ;
+}
+
+static bool find_constant(const char *name, long long *value)
+{
+	for (int i=g_const_count-1 ; i>=0 ; i--) {
+		if ( !strcmp(g_consts[i].name, name) ) {
+			*value = g_consts[i].value ;
+			return true ;
+		}
+	}
+	return false ;
+}
+
+static void add_constant(const char *name, long long value)
+{
+	g_consts = grow(g_consts, &g_const_cap, g_const_count+1, sizeof(*g_consts)) ;
+	g_consts[g_const_count++] = (struct constant) { strdup(name), value } ;
+}
+
+static char *read_all(FILE *fp, size_t *len)
+{
+	size_t cap = 1 << 16, n = 0 ;
+	char *buf = malloc(cap) ;
+	size_t got ;
+	while ( (got = fread(buf + n, 1, cap - n - 1, fp)) > 0 ) {
+		n += got ;
+		if ( cap - n - 1 == 0 ) buf = realloc(buf, cap *= 2) ;
+	}
+	buf[n] = '\0' ;
+	*len = n ;
+	return buf ;
+}
+
+//--------------------------------------------------------------------------------
+// C tokens
+//--------------------------------------------------------------------------------
+
+enum tok_kind { TK_END, TK_IDENT, TK_NUM, TK_PUNCT, TK_OTHER } ;
+
+struct token {
+	enum tok_kind kind ;
+	char text[4] ;                      // punctuator
+	char *ident ;
+	long long num ;
+} ;
+
+struct lexer {
+	struct token *toks ;
+	int count, cap, pos ;
+} ;
+
+static void push_tok(struct lexer *lx, struct token t)
+{
+	lx->toks = grow(lx->toks, &lx->cap, lx->count+1, sizeof(*lx->toks)) ;
+	lx->toks[lx->count++] = t ;
+}
+
+static const char *char_const(const char *p, long long *value)
+{
+	p++ ;                               // opening quote
+	long long v = 0 ;
+	for ( ; *p && *p != '\'' ; p++) {
+		int c = (unsigned char) *p ;
+		if ( c == '\\' ) {
+			p++ ;
+			switch ( *p ) {
+			case 'n': c = '\n' ; break ;
+			case 't': c = '\t' ; break ;
+			case 'r': c = '\r' ; break ;
+			case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7':
+				c = strtol(p, (char **) &p, 8) ; p-- ; break ;
+			case 'x': c = strtol(p+1, (char **) &p, 16) ; p-- ; break ;
+			default: c = (unsigned char) *p ; break ;
+			}
+		}
+		v = (v << 8) | (c & 0xff) ;
+	}
+	*value = v ;
+	return *p ? p+1 : p ;
+}
+
+static void tokenize(struct lexer *lx, const char *p)
+{
+	static const char *const puncts2[] = { "<<", ">>", "<=", ">=", "==", "!=", "&&", "||", "[[", "]]", NULL } ;
+	bool line_start = true ;
+	while ( *p ) {
+		if ( *p == '\n' ) { line_start = true ; p++ ; continue ; }
+		if ( isspace((unsigned char) *p) ) { p++ ; continue ; }
+		if ( line_start && *p == '#' ) {          // line markers and leftover directives
+			while ( *p && *p != '\n' ) p++ ;
+			continue ;
+		}
+		line_start = false ;
+		if ( p[0] == '/' && p[1] == '/' ) { while ( *p && *p != '\n' ) p++ ; continue ; }
+		if ( p[0] == '/' && p[1] == '*' ) {
+			const char *end = strstr(p+2, "*/") ;
+			p = end ? end+2 : p + strlen(p) ;
+			continue ;
+		}
+		if ( isalpha((unsigned char) *p) || *p == '_' ) {
+			const char *s = p ;
+			while ( isalnum((unsigned char) *p) || *p == '_' ) p++ ;
+			push_tok(lx, (struct token) { .kind = TK_IDENT, .ident = strndup(s, p - s) }) ;
+			continue ;
+		}
+		if ( isdigit((unsigned char) *p) ) {
+			char *end ;
+			long long v = (long long) strtoull(p, &end, 0) ;
+			while ( isalnum((unsigned char) *end) ) end++ ;   // u, l, ll suffixes
+			push_tok(lx, (struct token) { .kind = TK_NUM, .num = v }) ;
+			p = end ;
+			continue ;
+		}
+		if ( *p == '\'' ) {
+			struct token t = { .kind = TK_NUM } ;
+			p = char_const(p, &t.num) ;
+			push_tok(lx, t) ;
+			continue ;
+		}
+		if ( *p == '"' ) {                          // strings only matter as something to skip
+			for (p++ ; *p && *p != '"' ; p++) if ( *p == '\\' && p[1] ) p++ ;
+			if ( *p ) p++ ;
+			push_tok(lx, (struct token) { .kind = TK_OTHER }) ;
+			continue ;
+		}
+		struct token t = { .kind = TK_PUNCT } ;
+		for (int k=0 ; puncts2[k] ; k++) {
+			if ( !strncmp(p, puncts2[k], 2) ) {
+				memcpy(t.text, p, 2) ;
+				break ;
+			}
+		}
+		if ( !t.text[0] ) t.text[0] = *p ;
+		p += strlen(t.text) ;
+		push_tok(lx, t) ;
+	}
+	push_tok(lx, (struct token) { .kind = TK_END }) ;
+}
+
+static struct token *peek(struct lexer *lx)
+{
+	return &lx->toks[lx->pos] ;
+}
+
+static bool is_punct(struct lexer *lx, const char *s)
+{
+	struct token *t = peek(lx) ;
+	return t->kind == TK_PUNCT && !strcmp(t->text, s) ;
+}
+
+static bool is_ident(struct lexer *lx, const char *s)
+{
+	struct token *t = peek(lx) ;
+	return t->kind == TK_IDENT && (!s || !strcmp(t->ident, s)) ;
+}
+
+static void expect(struct lexer *lx, const char *s)
+{
+	if ( !is_punct(lx, s) ) die("expected '%s'", s) ;
+	lx->pos++ ;
+}
+
+// Balanced (), [] or [[ ]] group starting at the current token.
+static void skip_group(struct lexer *lx)
+{
+	int depth = 0 ;
+	do {
+		struct token *t = peek(lx) ;
+		if ( t->kind == TK_END ) die("%s", "unbalanced brackets") ;
+		if ( t->kind == TK_PUNCT ) {
+			if ( !strcmp(t->text, "(") || !strcmp(t->text, "[") ) depth++ ;
+			else if ( !strcmp(t->text, "[[") ) depth += 2 ;
+			else if ( !strcmp(t->text, ")") || !strcmp(t->text, "]") ) depth-- ;
+			else if ( !strcmp(t->text, "]]") ) depth -= 2 ;
+		}
+		lx->pos++ ;
+	} while ( depth > 0 ) ;
+}
+
+static void skip_attributes(struct lexer *lx)
+{
+	for (;;) {
+		if ( is_ident(lx, "__attribute__") || is_ident(lx, "__attribute") || is_ident(lx, "__declspec") ) {
+			lx->pos++ ;
+			skip_group(lx) ;
+		} else if ( is_punct(lx, "[[") ) {
+			skip_group(lx) ;
+		} else {
+			return ;
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------
+// Constant expressions, C precedence
+//--------------------------------------------------------------------------------
+
+static long long eval_cond(struct lexer *lx) ;
+
+// "(type)": identifiers only, none of them a known constant.
+static bool at_cast(struct lexer *lx)
+{
+	int i = lx->pos + 1 ;
+	long long v ;
+	if ( lx->toks[i].kind != TK_IDENT ) return false ;
+	for ( ; lx->toks[i].kind == TK_IDENT ; i++) {
+		if ( find_constant(lx->toks[i].ident, &v) ) return false ;
+	}
+	return lx->toks[i].kind == TK_PUNCT && !strcmp(lx->toks[i].text, ")") ;
+}
+
+static long long eval_unary(struct lexer *lx)
+{
+	struct token *t = peek(lx) ;
+	if ( t->kind == TK_NUM ) {
+		lx->pos++ ;
+		return t->num ;
+	}
+	if ( t->kind == TK_IDENT ) {
+		long long v ;
+		if ( !find_constant(t->ident, &v) ) die("unknown constant '%s'", t->ident) ;
+		lx->pos++ ;
+		return v ;
+	}
+	if ( is_punct(lx, "(") ) {
+		if ( at_cast(lx) ) {
+			while ( !is_punct(lx, ")") ) lx->pos++ ;
+			lx->pos++ ;
+			return eval_unary(lx) ;
+		}
+		lx->pos++ ;
+		long long v = eval_cond(lx) ;
+		expect(lx, ")") ;
+		return v ;
+	}
+	if ( t->kind == TK_PUNCT && strchr("-+~!", t->text[0]) && !t->text[1] ) {
+		lx->pos++ ;
+		long long v = eval_unary(lx) ;
+		switch ( t->text[0] ) {
+		case '-': return -v ;
+		case '~': return ~v ;
+		case '!': return !v ;
+		default: return v ;
+		}
+	}
+	die("%s", "unsupported expression") ;
+	return 0 ;
+}
+
+static int binary_prec(struct lexer *lx)
+{
+	static const struct { const char *op ; int prec ; } ops[] = {
+		{ "*", 10 }, { "/", 10 }, { "%", 10 }, { "+", 9 }, { "-", 9 }, { "<<", 8 }, { ">>", 8 },
+		{ "<", 7 }, { ">", 7 }, { "<=", 7 }, { ">=", 7 }, { "==", 6 }, { "!=", 6 },
+		{ "&", 5 }, { "^", 4 }, { "|", 3 }, { "&&", 2 }, { "||", 1 },
+	} ;
+	struct token *t = peek(lx) ;
+	if ( t->kind != TK_PUNCT ) return -1 ;
+	for (size_t k=0 ; k<sizeof(ops)/sizeof(ops[0]) ; k++) {
+		if ( !strcmp(t->text, ops[k].op) ) return ops[k].prec ;
+	}
+	return -1 ;
+}
+
+static long long eval_binary(struct lexer *lx, int min_prec)
+{
+	long long lhs = eval_unary(lx) ;
+	for (int prec ; (prec = binary_prec(lx)) >= min_prec ; ) {
+		char op[4] ;
+		strcpy(op, peek(lx)->text) ;
+		lx->pos++ ;
+		long long rhs = eval_binary(lx, prec + 1) ;
+		if ( (op[0] == '/' || op[0] == '%') && rhs == 0 ) die("%s", "division by zero") ;
+		if ( !strcmp(op, "*") ) lhs *= rhs ;
+		else if ( !strcmp(op, "/") ) lhs /= rhs ;
+		else if ( !strcmp(op, "%") ) lhs %= rhs ;
+		else if ( !strcmp(op, "+") ) lhs += rhs ;
+		else if ( !strcmp(op, "-") ) lhs -= rhs ;
+		else if ( !strcmp(op, "<<") ) lhs = (long long) ((unsigned long long) lhs << rhs) ;
+		else if ( !strcmp(op, ">>") ) lhs >>= rhs ;
+		else if ( !strcmp(op, "<") ) lhs = lhs < rhs ;
+		else if ( !strcmp(op, ">") ) lhs = lhs > rhs ;
+		else if ( !strcmp(op, "<=") ) lhs = lhs <= rhs ;
+		else if ( !strcmp(op, ">=") ) lhs = lhs >= rhs ;
+		else if ( !strcmp(op, "==") ) lhs = lhs == rhs ;
+		else if ( !strcmp(op, "!=") ) lhs = lhs != rhs ;
+		else if ( !strcmp(op, "&") ) lhs &= rhs ;
+		else if ( !strcmp(op, "^") ) lhs ^= rhs ;
+		else if ( !strcmp(op, "|") ) lhs |= rhs ;
+		else if ( !strcmp(op, "&&") ) lhs = lhs && rhs ;
+		else lhs = lhs || rhs ;
+	}
+	return lhs ;
+}
+
+static long long eval_cond(struct lexer *lx)
+{
+	long long c = eval_binary(lx, 1) ;
+	if ( !is_punct(lx, "?") ) return c ;
+	lx->pos++ ;
+	long long a = eval_cond(lx) ;
+	expect(lx, ":") ;
+	long long b = eval_cond(lx) ;
+	return c ? a : b ;
+}
+
+//--------------------------------------------------------------------------------
+// C input
+//--------------------------------------------------------------------------------
+
+// At "enum". Definitions only, "enum tag x ;" is a use.
+static void parse_enum(struct lexer *lx, bool in_typedef)
+{
+	lx->pos++ ;
+	skip_attributes(lx) ;
+	const char *tag = NULL ;
+	if ( is_ident(lx, NULL) ) tag = lx->toks[lx->pos++].ident ;
+	skip_attributes(lx) ;
+	if ( is_punct(lx, ":") ) {                  // fixed underlying type
+		while ( !is_punct(lx, "{") && !is_punct(lx, ";") && peek(lx)->kind != TK_END ) lx->pos++ ;
+	}
+	if ( !is_punct(lx, "{") ) return ;
+	lx->pos++ ;
+
+	struct enum_def tmp = { 0 } ;
+	long long next = 0 ;
+	while ( !is_punct(lx, "}") ) {
+		if ( !is_ident(lx, NULL) ) die("%s", "expected an enumerator") ;
+		const char *label = lx->toks[lx->pos++].ident ;
+		skip_attributes(lx) ;
+		if ( is_punct(lx, "=") ) {
+			lx->pos++ ;
+			next = eval_cond(lx) ;
+		}
+		add_item(&tmp, label, next) ;
+		add_constant(label, next) ;
+		next++ ;
+		if ( is_punct(lx, ",") ) lx->pos++ ;
+		else if ( !is_punct(lx, "}") ) die("unexpected token after '%s'", label) ;
+	}
+	lx->pos++ ;
+	if ( !tag && in_typedef ) {
+		skip_attributes(lx) ;
+		if ( is_ident(lx, NULL) ) tag = lx->toks[lx->pos].ident ;
+	}
+	if ( !tag || !tmp.count ) return ;         // anonymous: constants only
+	for (int i=0 ; i<g_enum_count ; i++) {
+		if ( !strcmp(g_enums[i].name, tag) ) return ;     // seen in an earlier input
+	}
+	struct enum_def *e = new_enum(tag) ;
+	e->entries = tmp.entries ;
+	e->count = tmp.count ;
+	e->cap = tmp.cap ;
+}
+
+static void read_c(const char *buf)
+{
+	struct lexer lx = { 0 } ;
+	tokenize(&lx, buf) ;
+	bool in_typedef = false ;
+	while ( peek(&lx)->kind != TK_END ) {
+		if ( is_ident(&lx, "enum") ) {
+			parse_enum(&lx, in_typedef) ;
+			continue ;
+		}
+		// Only "typedef enum { } name" names the enum: a member enum of a typedef'd
+		// struct or union comes after a "{" and would take the member name.
+		if ( is_ident(&lx, "typedef") ) in_typedef = true ;
+		else if ( is_punct(&lx, ";") || is_punct(&lx, "{") ) in_typedef = false ;
+		lx.pos++ ;
+	}
+}
+
+//--------------------------------------------------------------------------------
+// Manifest
+//--------------------------------------------------------------------------------
+
+static void read_manifest(char *buf)
+{
+	struct enum_def *e = NULL ;
+	long long next = 0 ;
+	for (char *line = strtok(buf, "\n") ; line ; line = strtok(NULL, "\n")) {
+		char *hash = strchr(line, '#') ;
+		if ( hash ) *hash = '\0' ;
+		char word[256], value[64] ;
+		int n = sscanf(line, "%255s %63s", word, value) ;
+		if ( n <= 0 ) continue ;
+		if ( !strcmp(word, "enum") ) {
+			if ( n < 2 ) die("%s", "enum without a name") ;
+			e = new_enum(value) ;
+			next = 0 ;
+			continue ;
+		}
+		if ( !e ) die("'%s' before the first enum line", word) ;
+		if ( n == 2 ) {
+			char *end ;
+			next = strtoll(value, &end, 0) ;
+			if ( *end && !find_constant(value, &next) ) die("bad value '%s'", value) ;
+		}
+		add_item(e, word, next) ;
+		add_constant(word, next) ;
+		next++ ;
+	}
+}
+
+//--------------------------------------------------------------------------------
+// Label sets (-l), same transforms as the plugin
+//--------------------------------------------------------------------------------
+
+enum { LSET_STRIP_PREFIX, LSET_LOWER, LSET_UPPER } ;
+#define LSET_TRANSFORMS_MAX 8
+
+struct label_set_spec {
+	char *name ;
+	int transforms[LSET_TRANSFORMS_MAX] ;
+	int transform_count ;
+} ;
+static struct label_set_spec *g_label_sets ;
+static int g_label_set_count, g_label_set_cap ;
+
+// wire:strip-prefix+lower
+static void add_label_set(const char *arg)
+{
+	g_input = "-l" ;
+	g_label_sets = grow(g_label_sets, &g_label_set_cap, g_label_set_count+1, sizeof(*g_label_sets)) ;
+	struct label_set_spec *spec = &g_label_sets[g_label_set_count++] ;
+	const char *colon = strchr(arg, ':') ;
+	*spec = (struct label_set_spec) { .name = strndup(arg, colon ? colon - arg : strlen(arg)) } ;
+	if ( !*spec->name ) die("%s", "label set needs a name") ;
+	for (const char *t = colon ? colon + 1 : NULL ; t && *t ; ) {
+		size_t len = strcspn(t, "+") ;
+		char name[32] ;
+		snprintf(name, sizeof(name), "%.*s", (int) len, t) ;
+		if ( spec->transform_count == LSET_TRANSFORMS_MAX ) die("too many transforms at '%s'", name) ;
+		int *tr = &spec->transforms[spec->transform_count++] ;
+		if ( !strcmp(name, "strip-prefix") ) *tr = LSET_STRIP_PREFIX ;
+		else if ( !strcmp(name, "lower") ) *tr = LSET_LOWER ;
+		else if ( !strcmp(name, "upper") ) *tr = LSET_UPPER ;
+		else die("unknown label set transform '%s'", name) ;
+		t += len + (t[len] == '+') ;
+	}
+}
+
+// Labels of one set, malloc'd. A label the transforms would leave empty stays as declared.
+static char **transform_labels(const struct enum_def *e, const struct label_set_spec *spec)
+{
+	int n = e->count ;
+	char **out = calloc(n, sizeof(*out)) ;
+	for (int i=0 ; i<n ; i++) out[i] = strdup(e->entries[i].name) ;
+	for (int t=0 ; t<spec->transform_count ; t++) {
+		if ( spec->transforms[t] == LSET_STRIP_PREFIX ) {
+			if ( n < 2 ) continue ;
+			size_t common = strlen(out[0]) ;
+			for (int i=0 ; i<n ; i++) {
+				size_t k = 0 ;
+				while ( k < common && out[i][k] && out[i][k] == out[0][k] ) k++ ;
+				common = k ;
+			}
+			// Last '_' at or before common-1
+			long cut = common ? (long) common - 1 : 0 ;
+			while ( cut >= 0 && out[0][cut] != '_' ) cut-- ;
+			if ( cut < 0 || (size_t) cut >= common ) continue ;
+			for (int i=0 ; i<n ; i++) {
+				if ( strlen(out[i]) > (size_t) cut + 1 ) memmove(out[i], out[i] + cut + 1, strlen(out[i] + cut + 1) + 1) ;
+			}
+		}
+		else {
+			for (int i=0 ; i<n ; i++) {
+				for (char *c = out[i] ; *c ; c++) *c = spec->transforms[t] == LSET_LOWER ? tolower((unsigned char) *c) : toupper((unsigned char) *c) ;
+			}
+		}
+	}
+	return out ;
+}
+
+//--------------------------------------------------------------------------------
+// Output, same objects and order as the plugin
+//--------------------------------------------------------------------------------
+
+static void put_ints(FILE *fp, const char *type, const char *sym, const char *esym, const void *a, int n, int size)
+{
+	fprintf(fp, "static const %s %s%s[%d] = {", type, sym, esym, n) ;
+	for (int i=0 ; i<n ; i++) {
+		long long v = size == 4 ? *((const int32_t *) a + i) : size == 2 ? *((const int16_t *) a + i) : 0 ;
+		if ( size == 2 && type[0] == 'u' ) v = (uint16_t) v ;
+		if ( size == 4 && type[0] == 'u' ) v = (uint32_t) v ;
+		fprintf(fp, "%s%lld", !i ? "\n\t" : i % 16 ? ", " : ",\n\t", v) ;
+	}
+	fprintf(fp, "\n} ;\n") ;
+}
+
+static void put_list(FILE *fp, const char *field, const void *a, int n, int size, bool is_unsigned)
+{
+	fprintf(fp, "\t.%s = {", field) ;
+	for (int i=0 ; i<n ; i++) {
+		long long v = size == 4 ? *((const int32_t *) a + i) : *((const int16_t *) a + i) ;
+		if ( is_unsigned ) v = size == 4 ? (long long) (uint32_t) v : (long long) (uint16_t) v ;
+		fprintf(fp, "%s%lld", !i ? "\n\t\t" : i % 16 ? ", " : ",\n\t\t", v) ;
+	}
+	fprintf(fp, "\n\t},\n") ;
+}
+
+// n bytes as a literal, the array size drops the implicit NUL.
+static void put_blob(FILE *fp, const char *s, size_t n)
+{
+	fprintf(fp, "\"") ;
+	for (size_t i=0 ; i+1<n ; i++) {
+		unsigned char c = s[i] ;
+		if ( c == '\0' ) fprintf(fp, i+2 < n && s[i+1] ? "\\0\"\n\t\t\"" : "\\0") ;
+		else if ( c == '"' || c == '\\' || !isprint(c) ) fprintf(fp, "\\%03o", c) ;
+		else fputc(c, fp) ;
+	}
+	fprintf(fp, "\"") ;
+}
+
+static size_t trie_segs_len(const struct enum_desc_trie *trie)
+{
+	size_t len = 0 ;
+	for (int k=0 ; k<trie->node_count ; k++) {
+		if ( trie->seg_off[k] + trie->seg_len[k] > len ) len = trie->seg_off[k] + trie->seg_len[k] ;
+	}
+	return len ;
+}
+
+// Node arrays of a trie, __enum_trie<array>_<esym>.
+static void emit_trie_arrays(FILE *fp, const char *esym, const struct enum_desc_trie *trie, int n)
+{
+	int nodes = trie->node_count ;
+	put_ints(fp, "uint32_t", "__enum_trieseg_off_", esym, trie->seg_off, nodes, 4) ;
+	put_ints(fp, "uint16_t", "__enum_trieseg_len_", esym, trie->seg_len, nodes, 2) ;
+	put_ints(fp, "uint16_t", "__enum_trieparent_", esym, trie->parent, nodes, 2) ;
+	put_ints(fp, "uint16_t", "__enum_triechild_", esym, trie->child, nodes+1, 2) ;
+	put_ints(fp, "enum_desc_idx", "__enum_trieterm_", esym, trie->term, nodes, 2) ;
+	put_ints(fp, "uint16_t", "__enum_trieleaf_", esym, trie->leaf, n, 2) ;
+}
+
+static void emit_trie(FILE *fp, const char *esym, const struct enum_desc_trie *trie, const char *segs)
+{
+	fprintf(fp, "static const struct enum_desc_trie __enum_trie_%s = {\n", esym) ;
+	fprintf(fp, "\t.node_count = %d,\n", trie->node_count) ;
+	fprintf(fp, "\t.seg_off = __enum_trieseg_off_%s,\n\t.seg_len = __enum_trieseg_len_%s,\n", esym, esym) ;
+	fprintf(fp, "\t.parent = __enum_trieparent_%s,\n\t.child = __enum_triechild_%s,\n", esym, esym) ;
+	fprintf(fp, "\t.term = __enum_trieterm_%s,\n\t.leaf = __enum_trieleaf_%s,\n", esym, esym) ;
+	fprintf(fp, "\t.segs = %s,\n} ;\n", segs) ;
+}
+
+// __enum_lsets_<E>: per set its labels blob, offsets and trie (edges into the blob).
+static void emit_label_sets(FILE *fp, const char *S, enum_desc_t ed)
+{
+	int n = ed->value_count ;
+	char sym[256], segs[256] ;
+	for (int k=0 ; k<ed->label_set_count ; k++) {
+		const struct enum_desc_label_set *ls = &ed->label_sets[k] ;
+		size_t len = ls->lbl_off[n-1] + strlen(ls->strs + ls->lbl_off[n-1])+1 + 8 ;
+		if ( len >= 65536 ) {
+			g_input = S ;
+			die("%s", "label set too large for uint16 offsets") ;
+		}
+		fprintf(fp, "static const char __enum_lsetstr%d_%s[%zu] =\n\t\t", k+1, S, len) ;
+		put_blob(fp, ls->strs, len) ;
+		fprintf(fp, " ;\n") ;
+		snprintf(sym, sizeof(sym), "__enum_lsetoff%d_", k+1) ;
+		put_ints(fp, "uint16_t", sym, S, ls->lbl_off, n, 2) ;
+		if ( ls->trie ) {
+			snprintf(sym, sizeof(sym), "%s_set%d", S, k+1) ;
+			snprintf(segs, sizeof(segs), "__enum_lsetstr%d_%s", k+1, S) ;
+			emit_trie_arrays(fp, sym, ls->trie, n) ;
+			emit_trie(fp, sym, ls->trie, segs) ;
+		}
+	}
+	fprintf(fp, "static const struct enum_desc_label_set __enum_lsets_%s[%d] = {\n", S, ed->label_set_count) ;
+	for (int k=0 ; k<ed->label_set_count ; k++) {
+		fprintf(fp, "\t{ .strs = __enum_lsetstr%d_%s, .lbl_off = __enum_lsetoff%d_%s", k+1, S, k+1, S) ;
+		if ( ed->label_sets[k].trie ) fprintf(fp, ", .trie = &__enum_trie_%s_set%d", S, k+1) ;
+		fprintf(fp, " },\n") ;
+	}
+	fprintf(fp, "} ;\n") ;
+}
+
+static void emit_enum(FILE *fp, const struct enum_def *e)
+{
+	if ( !e->count ) {
+		g_input = e->name ;
+		die("%s", "enum has no items") ;
+	}
+	struct enum_desc_label_set_def defs[g_label_set_count + 1] ;
+	for (int k=0 ; k<g_label_set_count ; k++) {
+		defs[k] = (struct enum_desc_label_set_def) { g_label_sets[k].name, (const char *const *) transform_labels(e, &g_label_sets[k]) } ;
+	}
+	enum_desc_t ed = enum_refl_build_sets(NULL, e->name, e->entries, NULL, defs, g_label_set_count) ;
+	for (int k=0 ; k<g_label_set_count ; k++) {
+		for (int i=0 ; i<e->count ; i++) free((char *) defs[k].labels[i]) ;
+		free((void *) defs[k].labels) ;
+	}
+	const char *S = e->name ;
+	int n = ed->value_count ;
+	bool trie_only = ed->flags & ENUM_DESC_F_TRIE_LABELS ;
+	const struct enum_desc_trie *trie = ed->trie ;
+	uint32_t words = ed->value_bits ? ((uint32_t) ed->value_max - (uint32_t) ed->value_min) / 32 + 1 : 0 ;
+
+	// strs as the plugin lays it out: name, labels, 8 NUL
+	size_t strs_len = strlen(S)+1 + 8 ;
+	if ( !trie_only ) strs_len = ed->lbl_off[n-1] + strlen(ed->strs + ed->lbl_off[n-1])+1 + 8 ;
+	char *strs = calloc(strs_len, 1) ;
+	memcpy(strs, ed->strs, strs_len - 8) ;
+	if ( strs_len >= 65536 ) {
+		g_input = S ;
+		die("%s", "labels too large for uint16 offsets") ;
+	}
+
+	fprintf(fp, "\n// %s: %d items\n", S, n) ;
+	if ( ed->alias_next ) put_ints(fp, "enum_desc_idx", "__enum_alias_", S, ed->alias_next, n, 2) ;
+	int blk_count = trie_only ? 0 : (ed->lbl_off[n-1] >> 3) + 1 ;
+	if ( blk_count ) put_ints(fp, "enum_desc_idx", "__enum_lblblk_", S, ed->lbl_blk, blk_count, 2) ;
+	put_ints(fp, "enum_desc_idx", "__enum_bylabel_", S, ed->by_label, n, 2) ;
+	if ( trie ) {
+		emit_trie_arrays(fp, S, trie, n) ;
+		if ( trie_only ) {
+			size_t segs_len = trie_segs_len(trie) + 1 ;
+			fprintf(fp, "static const char __enum_trieseg_%s[%zu] =\n\t\t", S, segs_len) ;
+			char *segs = calloc(segs_len, 1) ;
+			memcpy(segs, trie->segs, segs_len - 1) ;
+			put_blob(fp, segs, segs_len) ;
+			free(segs) ;
+			fprintf(fp, " ;\nstatic void *__enum_lblcache_%s ;\n", S) ;
+		}
+		fprintf(fp, "static const struct enum_desc_trie __enum_trie_%s ;\n", S) ;
+	}
+	if ( ed->label_set_count ) emit_label_sets(fp, S, ed) ;
+
+	fprintf(fp, "static const struct {\n\tstruct enum_desc hdr ;\n\tenum_desc_val vals[%d] ;\n", n) ;
+	if ( !trie_only ) fprintf(fp, "\tuint16_t lbloff[%d] ;\n", n) ;
+	fprintf(fp, "\tchar lblstr[%zu] ;\n", strs_len) ;
+	if ( words ) fprintf(fp, "\tuint32_t valbits[%u] ;\n\tuint16_t valrank[%u] ;\n", words, words) ;
+	fprintf(fp, "\tenum_desc_idx byval[%d] ;\n", ed->uniq_count) ;
+	fprintf(fp, "} __enum_pack_%s __attribute__((aligned(64))) = {\n", S) ;
+	fprintf(fp, "\t.hdr = {\n") ;
+	fprintf(fp, "\t\t.value_count = %d,\n", n) ;
+	fprintf(fp, "\t\t.flags = %s%s,\n", "ENUM_DESC_F_RANGE", trie_only ? " | ENUM_DESC_F_TRIE_LABELS" : "") ;
+	fprintf(fp, "\t\t.values = __enum_pack_%s.vals,\n", S) ;
+	if ( !trie_only ) fprintf(fp, "\t\t.lbl_off = __enum_pack_%s.lbloff,\n", S) ;
+	fprintf(fp, "\t\t.strs = __enum_pack_%s.lblstr,\n", S) ;
+	fprintf(fp, "\t\t.value_min = %d,\n\t\t.value_max = %d,\n", ed->value_min, ed->value_max) ;
+	if ( words ) fprintf(fp, "\t\t.value_bits = __enum_pack_%s.valbits,\n\t\t.value_rank = __enum_pack_%s.valrank,\n", S, S) ;
+	fprintf(fp, "\t\t.uniq_count = %d,\n\t\t.by_value = __enum_pack_%s.byval,\n", ed->uniq_count, S) ;
+	if ( ed->alias_next ) fprintf(fp, "\t\t.alias_next = __enum_alias_%s,\n", S) ;
+	if ( blk_count ) fprintf(fp, "\t\t.lbl_blk = __enum_lblblk_%s,\n", S) ;
+	if ( trie ) fprintf(fp, "\t\t.trie = &__enum_trie_%s,\n", S) ;
+	if ( trie_only ) fprintf(fp, "\t\t.lbl_cache = &__enum_lblcache_%s,\n", S) ;
+	if ( ed->label_set_count ) fprintf(fp, "\t\t.label_set_count = %d,\n\t\t.label_sets = __enum_lsets_%s,\n", ed->label_set_count, S) ;
+	fprintf(fp, "\t\t.by_label = __enum_bylabel_%s,\n", S) ;
+	fprintf(fp, "\t\t.fingerprint = 0x%016llxull,\n", (unsigned long long) ed->fingerprint) ;
+	fprintf(fp, "\t},\n") ;
+	put_list(fp, "vals", ed->values, n, 4, false) ;
+	if ( !trie_only ) put_list(fp, "lbloff", ed->lbl_off, n, 2, true) ;
+	fprintf(fp, "\t.lblstr = ") ;
+	put_blob(fp, strs, strs_len) ;
+	fprintf(fp, ",\n") ;
+	if ( words ) {
+		put_list(fp, "valbits", ed->value_bits, words, 4, true) ;
+		put_list(fp, "valrank", ed->value_rank, words, 2, true) ;
+	}
+	put_list(fp, "byval", ed->by_value, ed->uniq_count, 2, false) ;
+	fprintf(fp, "} ;\n") ;
+
+	if ( trie ) {
+		char segs[256] ;
+		snprintf(segs, sizeof(segs), trie_only ? "__enum_trieseg_%s" : "__enum_pack_%s.lblstr", S) ;
+		emit_trie(fp, S, trie, segs) ;
+	}
+	fprintf(fp, "extern const struct enum_desc __enum_desc__%s __attribute__((alias(\"__enum_pack_%s\"))) ;\n", S, S) ;
+	fprintf(fp, "static const struct enum_desc *const __enum_reg_%s __attribute__((used, section(\"enum_desc_reg\"))) = &__enum_desc__%s ;\n", S, S) ;
+	free(strs) ;
+	enum_desc_destroy(ed) ;
+}
+
+static bool selected(const char *name, char **only, int only_count)
+{
+	if ( !only_count ) return true ;
+	for (int i=0 ; i<only_count ; i++) {
+		if ( !strcmp(only[i], name) ) return true ;
+	}
+	return false ;
+}
+
+int main(int argc, char **argv)
+{
+	const char *out_path = NULL ;
+	char **only = calloc(argc, sizeof(*only)) ;
+	int only_count = 0, inputs = 0 ;
+	for (int i=1 ; i<argc ; i++) {
+		bool manifest = false ;
+		const char *path = argv[i] ;
+		if ( (!strcmp(argv[i], "-o") || !strcmp(argv[i], "-e") || !strcmp(argv[i], "-l") || !strcmp(argv[i], "-m")) && i+1 >= argc ) {
+			fprintf(stderr, "enum_desc_tablegen: %s needs an argument\n", argv[i]) ;
+			return 2 ;
+		}
+		if ( !strcmp(argv[i], "-o") ) { out_path = argv[++i] ; continue ; }
+		if ( !strcmp(argv[i], "-e") ) { only[only_count++] = argv[++i] ; continue ; }
+		if ( !strcmp(argv[i], "-l") ) { add_label_set(argv[++i]) ; continue ; }
+		if ( !strcmp(argv[i], "-m") ) { manifest = true ; path = argv[++i] ; }
+		FILE *fp = strcmp(path, "-") ? fopen(path, "r") : stdin ;
+		if ( !fp ) {
+			perror(path) ;
+			return 1 ;
+		}
+		size_t len ;
+		char *buf = read_all(fp, &len) ;
+		if ( fp != stdin ) fclose(fp) ;
+		g_input = path ;
+		if ( manifest ) read_manifest(buf) ; else read_c(buf) ;
+		free(buf) ;
+		inputs++ ;
+	}
+	if ( !inputs ) {
+		fprintf(stderr, "usage: %s [-o out.c] [-e enum]... [-l set[:transform]...]... [-m manifest]... [file.i | -]...\n", argv[0]) ;
+		return 2 ;
+	}
+	for (int i=0 ; i<only_count ; i++) {
+		bool found = false ;
+		for (int k=0 ; k<g_enum_count && !found ; k++) found = !strcmp(g_enums[k].name, only[i]) ;
+		if ( !found ) {
+			fprintf(stderr, "enum_desc_tablegen: enum %s not found\n", only[i]) ;
+			return 1 ;
+		}
+	}
+
+	FILE *out = out_path ? fopen(out_path, "w") : stdout ;
+	if ( !out ) {
+		perror(out_path) ;
+		return 1 ;
+	}
+	fprintf(out, "// Generated by enum_desc_tablegen, do not edit.\n") ;
+	fprintf(out, "#include \"enum_desc_def.h\"\n") ;
+	for (int k=0 ; k<g_enum_count ; k++) {
+		if ( selected(g_enums[k].name, only, only_count) ) emit_enum(out, &g_enums[k]) ;
+	}
+	if ( out != stdout && fclose(out) ) {
+		perror(out_path) ;
+		return 1 ;
+	}
+	free(only) ;
+	return 0 ;
+}
@@ -0,0 +1,142 @@
+#include "enum_desc_impl.h"
+
+//--------------------------------------------------------------------------------
+// Radix trie over labels. Built breadth first from the labels in strcmp order:
+// each node covers a run of sorted labels sharing its prefix, the edge to a child
+// is the common prefix of the first and last label of the child's run.
+// The plugin emits the same layout (gcc_enum_reflect.cc, build_lbl_trie).
+//--------------------------------------------------------------------------------
+
+struct trie_label {
+	const char *label ;
+	size_t len ;
+	enum_desc_idx idx ;
+} ;
+
+static int cmp_trie_label(const void *a, const void *b)
+{
+	const struct trie_label *x = a, *y = b ;
+	int c = strcmp(x->label, y->label) ;
+	if ( c ) return c ;
+	return x->idx - y->idx ;
+}
+
+struct trie_span {
+	int lo, hi ;                        // run of sorted labels
+	size_t depth ;                      // prefix length at the node
+} ;
+
+struct enum_desc_trie *enum_desc_trie_build(struct enum_desc_arena *arena, const char *const *labels, int count, const char *base)
+{
+	int cap = 2*count + 1 ;             // a radix trie has at most 2n-1 nodes, plus the root
+	if ( cap > UINT16_MAX ) return NULL ;
+
+	size_t total = 0 ;
+	struct trie_label *sorted = calloc(count+1, sizeof(*sorted)) ;
+	for (int i=0 ; i<count ; i++) {
+		sorted[i] = (struct trie_label) { .label = labels[i], .len = strlen(labels[i]), .idx = i } ;
+		total += sorted[i].len ;
+	}
+	qsort(sorted, count, sizeof(*sorted), cmp_trie_label) ;
+
+	struct trie_span *span = calloc(cap, sizeof(*span)) ;
+	struct enum_desc_trie *trie = enum_desc_alloc(arena, 1, sizeof(*trie)) ;
+	uint32_t *seg_off = enum_desc_alloc(arena, cap, sizeof(*seg_off)) ;
+	uint16_t *seg_len = enum_desc_alloc(arena, cap, sizeof(*seg_len)) ;
+	uint16_t *parent = enum_desc_alloc(arena, cap, sizeof(*parent)) ;
+	uint16_t *child = enum_desc_alloc(arena, cap+1, sizeof(*child)) ;
+	enum_desc_idx *term = enum_desc_alloc(arena, cap, sizeof(*term)) ;
+	uint16_t *leaf = enum_desc_alloc(arena, count+1, sizeof(*leaf)) ;
+	char *segs = base ? NULL : enum_desc_alloc(arena, total+1, 1) ;
+	uint32_t segs_len = 0 ;
+
+	int n = 1 ;
+	span[0] = (struct trie_span) { .lo = 0, .hi = count, .depth = 0 } ;
+	for (int i=0 ; i<n ; i++) {
+		int lo = span[i].lo, hi = span[i].hi ;
+		size_t depth = span[i].depth ;
+		child[i] = n ;
+		term[i] = ENUM_DESC_NOT_FOUND ;
+		// Labels ending here sort first in the run, lowest index first.
+		for ( ; lo<hi && sorted[lo].len == depth ; lo++) {
+			if ( term[i] == ENUM_DESC_NOT_FOUND ) term[i] = sorted[lo].idx ;
+			leaf[sorted[lo].idx] = i ;
+		}
+		for (int a=lo, b ; a<hi ; a=b) {
+			const char *first = sorted[a].label ;
+			for (b=a+1 ; b<hi && sorted[b].label[depth] == first[depth] ; b++) ;
+			const char *last = sorted[b-1].label ;
+			size_t k = depth ;
+			while ( first[k] && first[k] == last[k] ) k++ ;
+			if ( base ) {
+				seg_off[n] = (first - base) + depth ;
+			} else {
+				seg_off[n] = segs_len ;
+				memcpy(segs + segs_len, first + depth, k - depth) ;
+				segs_len += k - depth ;
+			}
+			seg_len[n] = k - depth ;
+			parent[n] = i ;
+			span[n++] = (struct trie_span) { .lo = a, .hi = b, .depth = k } ;
+		}
+	}
+	child[n] = n ;
+	free(span) ;
+	free(sorted) ;
+
+	*trie = (struct enum_desc_trie) {
+		.node_count = n,
+		.seg_off = seg_off,
+		.seg_len = seg_len,
+		.parent = parent,
+		.child = child,
+		.term = term,
+		.leaf = leaf,
+		.segs = base ? base : segs,
+	} ;
+	return trie ;
+}
+
+void enum_desc_trie_free(const struct enum_desc_trie *trie, bool own_segs)
+{
+	if ( !trie ) return ;
+	if ( own_segs ) free((void *) trie->segs) ;
+	free((void *) trie->seg_off) ;
+	free((void *) trie->seg_len) ;
+	free((void *) trie->parent) ;
+	free((void *) trie->child) ;
+	free((void *) trie->term) ;
+	free((void *) trie->leaf) ;
+	free((void *) trie) ;
+}
+
+enum_desc_idx enum_desc_trie_find(const struct enum_desc_trie *trie, const char *s, size_t len)
+{
+	int node = 0 ;
+	size_t pos = 0 ;
+	while ( pos < len ) {
+		int next = enum_desc_trie_child(trie, node, s[pos]) ;
+		if ( next < 0 ) return ENUM_DESC_NOT_FOUND ;
+		size_t seg_len = trie->seg_len[next] ;
+		if ( len - pos < seg_len || memcmp(trie->segs + trie->seg_off[next], s + pos, seg_len) ) return ENUM_DESC_NOT_FOUND ;
+		pos += seg_len ;
+		node = next ;
+	}
+	return trie->term[node] ;
+}
+
+int enum_desc_trie_copy(const struct enum_desc_trie *trie, enum_desc_idx idx, char *buf, size_t size)
+{
+	size_t len = 0 ;
+	for (int node = trie->leaf[idx] ; node ; node = trie->parent[node]) len += trie->seg_len[node] ;
+	// Fill back to front, from the leaf up.
+	size_t end = len ;
+	for (int node = trie->leaf[idx] ; node ; node = trie->parent[node]) {
+		size_t seg_len = trie->seg_len[node], begin = end - seg_len ;
+		const char *seg = trie->segs + trie->seg_off[node] ;
+		for (size_t k=begin ; k<end && k+1<size ; k++) buf[k] = seg[k-begin] ;
+		end = begin ;
+	}
+	if ( size ) buf[len < size ? len : size-1] = 0 ;
+	return len ;
+}
@@ -0,0 +1,294 @@
+#include "enum_refl.h"
+#include "enum_desc_def.h"
+#include <stdbool.h>
+#include <pthread.h>
+
+// Inputs smaller than this are not worth a thread hand-off.
+#define BULK_MIN_CHUNK 4096
+#define BULK_MAX_JOBS 256
+
+//--------------------------------------------------------------------------------
+// Job runner: split [0, n) into njobs contiguous chunks, run them on threads.
+//--------------------------------------------------------------------------------
+
+struct bulk_job {
+	size_t begin, end ;                 // input range (items or bytes)
+	size_t out_begin ;                  // first output slot (buffer mode, pass 2)
+	size_t count ;                      // tokens seen (buffer mode, pass 1)
+	size_t unknown_count ;
+	size_t unknown_used ;               // entries stored in unknown_idx
+	size_t unknown_cap ;
+	size_t *unknown_idx ;               // first unknown positions in this chunk
+} ;
+
+struct bulk_cxt {
+	enum_desc_t ed ;
+	const struct enum_refl_bulk_opts *opts ;
+	struct bulk_job *jobs ;
+	// array mode
+	const enum_desc_val *values_in ;
+	const char **labels_out ;
+	const char *default_label ;
+	const char *const *labels_in ;
+	enum_desc_val *values_out ;
+	enum_desc_val default_value ;
+	// buffer mode
+	const char *buf ;
+	size_t buf_len ;
+	char sep ;
+	size_t values_max ;
+} ;
+
+struct pthread_job {
+	pthread_t tid ;
+	enum_refl_job_fn job ;
+	void *job_cxt ;
+	int job_idx ;
+} ;
+
+static void *pthread_job_main(void *arg)
+{
+	struct pthread_job *pj = arg ;
+	pj->job(pj->job_cxt, pj->job_idx) ;
+	return NULL ;
+}
+
+// Default runner: one pthread per job, job 0 runs on the calling thread.
+static void pthread_runner(void *runner_cxt, int njobs, enum_refl_job_fn job, void *job_cxt)
+{
+	struct pthread_job pj[BULK_MAX_JOBS] ;
+	bool started[BULK_MAX_JOBS] = { false } ;
+	for (int i=1 ; i<njobs ; i++) {
+		pj[i] = (struct pthread_job) { .job = job, .job_cxt = job_cxt, .job_idx = i } ;
+		started[i] = pthread_create(&pj[i].tid, NULL, pthread_job_main, &pj[i]) == 0 ;
+		if ( !started[i] ) job(job_cxt, i) ;        // out of threads: run inline
+	}
+	job(job_cxt, 0) ;
+	for (int i=1 ; i<njobs ; i++) {
+		if ( started[i] ) pthread_join(pj[i].tid, NULL) ;
+	}
+}
+
+static void run_jobs(const struct enum_refl_bulk_opts *opts, int njobs, enum_refl_job_fn job, void *job_cxt)
+{
+	if ( njobs <= 1 ) {
+		job(job_cxt, 0) ;
+	} else if ( opts && opts->runner ) {
+		opts->runner(opts->runner_cxt, njobs, job, job_cxt) ;
+	} else {
+		pthread_runner(NULL, njobs, job, job_cxt) ;
+	}
+}
+
+static int job_count(const struct enum_refl_bulk_opts *opts, size_t n)
+{
+	int njobs = opts && opts->nthreads > 0 ? opts->nthreads : 1 ;
+	if ( njobs > BULK_MAX_JOBS ) njobs = BULK_MAX_JOBS ;
+	size_t max_jobs = (n + BULK_MIN_CHUNK - 1) / BULK_MIN_CHUNK ;
+	if ( (size_t) njobs > max_jobs ) njobs = max_jobs ? max_jobs : 1 ;
+	return njobs ;
+}
+
+static struct bulk_job *make_jobs(int njobs, size_t n)
+{
+	struct bulk_job *jobs = calloc(njobs, sizeof(*jobs)) ;
+	if ( !jobs ) return NULL ;
+	for (int i=0 ; i<njobs ; i++) {
+		jobs[i].begin = n * i / njobs ;
+		jobs[i].end = n * (i+1) / njobs ;
+	}
+	return jobs ;
+}
+
+// Per-job unknown buffers, sized once the chunk edges are final.
+// A chunk can not hold more unknowns than items (or bytes).
+static void alloc_unknown(const struct enum_refl_bulk_opts *opts, struct bulk_job *jobs, int njobs)
+{
+	size_t unknown_max = opts && opts->unknown_idx ? opts->unknown_max : 0 ;
+	for (int i=0 ; i<njobs ; i++) {
+		size_t len = jobs[i].end - jobs[i].begin ;
+		size_t cap = unknown_max < len ? unknown_max : len ;
+		if ( cap ) jobs[i].unknown_idx = malloc(cap * sizeof(size_t)) ;
+		jobs[i].unknown_cap = jobs[i].unknown_idx ? cap : 0 ;
+	}
+}
+
+static inline void note_unknown(struct bulk_job *j, size_t pos)
+{
+	if ( j->unknown_used < j->unknown_cap )
+		j->unknown_idx[j->unknown_used++] = pos ;
+	j->unknown_count++ ;
+}
+
+// Merge per-job unknown reports in input order, free job state.
+static size_t finish_jobs(const struct enum_refl_bulk_opts *opts, struct bulk_job *jobs, int njobs)
+{
+	size_t total = 0, used = 0 ;
+	size_t unknown_max = opts && opts->unknown_idx ? opts->unknown_max : 0 ;
+	for (int i=0 ; i<njobs ; i++) {
+		struct bulk_job *j = &jobs[i] ;
+		for (size_t k=0 ; k<j->unknown_used && used < unknown_max ; k++)
+			opts->unknown_idx[used++] = j->unknown_idx[k] ;
+		total += j->unknown_count ;
+		free(j->unknown_idx) ;
+	}
+	free(jobs) ;
+	return total ;
+}
+
+//--------------------------------------------------------------------------------
+// Array transcoding
+//--------------------------------------------------------------------------------
+
+static void label_of_job(void *arg, int job_idx)
+{
+	struct bulk_cxt *cxt = arg ;
+	struct bulk_job *j = &cxt->jobs[job_idx] ;
+	for (size_t i=j->begin ; i<j->end ; i++) {
+		enum_desc_idx idx = enum_refl_find_by_value(cxt->ed, cxt->values_in[i]) ;
+		if ( idx == ENUM_DESC_NOT_FOUND ) {
+			cxt->labels_out[i] = cxt->default_label ;
+			note_unknown(j, i) ;
+		} else {
+			cxt->labels_out[i] = enum_desc_label_at(cxt->ed, idx) ;
+		}
+	}
+}
+
+static void value_of_job(void *arg, int job_idx)
+{
+	struct bulk_cxt *cxt = arg ;
+	struct bulk_job *j = &cxt->jobs[job_idx] ;
+	for (size_t i=j->begin ; i<j->end ; i++) {
+		enum_desc_idx idx = cxt->labels_in[i] ? enum_refl_find_by_label(cxt->ed, cxt->labels_in[i]) : ENUM_DESC_NOT_FOUND ;
+		if ( idx == ENUM_DESC_NOT_FOUND ) {
+			cxt->values_out[i] = cxt->default_value ;
+			note_unknown(j, i) ;
+		} else {
+			cxt->values_out[i] = enum_desc_value_at(cxt->ed, idx) ;
+		}
+	}
+}
+
+size_t enum_refl_bulk_label_of(enum_desc_t ed, const enum_desc_val *values, size_t n,
+	const char **labels, const char *default_label, const struct enum_refl_bulk_opts *opts)
+{
+	int njobs = job_count(opts, n) ;
+	struct bulk_cxt cxt = {
+		.ed = ed, .opts = opts,
+		.values_in = values, .labels_out = labels, .default_label = default_label,
+		.jobs = make_jobs(njobs, n),
+	} ;
+	if ( !cxt.jobs ) return n ;
+	alloc_unknown(opts, cxt.jobs, njobs) ;
+	run_jobs(opts, njobs, label_of_job, &cxt) ;
+	return finish_jobs(opts, cxt.jobs, njobs) ;
+}
+
+size_t enum_refl_bulk_value_of(enum_desc_t ed, const char *const *labels, size_t n,
+	enum_desc_val *values, enum_desc_val default_value, const struct enum_refl_bulk_opts *opts)
+{
+	int njobs = job_count(opts, n) ;
+	struct bulk_cxt cxt = {
+		.ed = ed, .opts = opts,
+		.labels_in = labels, .values_out = values, .default_value = default_value,
+		.jobs = make_jobs(njobs, n),
+	} ;
+	if ( !cxt.jobs ) return n ;
+	alloc_unknown(opts, cxt.jobs, njobs) ;
+	run_jobs(opts, njobs, value_of_job, &cxt) ;
+	return finish_jobs(opts, cxt.jobs, njobs) ;
+}
+
+//--------------------------------------------------------------------------------
+// Buffer transcoding: sep-terminated tokens, chunk edges moved to token starts.
+// Pass 1 counts tokens per chunk, pass 2 writes each chunk at its prefix offset.
+//--------------------------------------------------------------------------------
+
+static enum_desc_idx find_token(enum_desc_t ed, const char *s, size_t len)
+{
+	enum_desc_ext_t ext = ed->ext ;
+	if ( !ext || !ext->find_by_label || ext->find_by_label == enum_desc_find_by_label )
+		return enum_desc_find_by_label_n(ed, s, len) ;
+
+	// Custom hook: needs a terminated copy.
+	char tmp[256], *label = len < sizeof(tmp) ? tmp : malloc(len + 1) ;
+	if ( !label ) return ENUM_DESC_NOT_FOUND ;
+	memcpy(label, s, len) ;
+	label[len] = 0 ;
+	enum_desc_idx idx = ext->find_by_label(ed, label) ;
+	if ( label != tmp ) free(label) ;
+	return idx ;
+}
+
+static size_t token_start(const struct bulk_cxt *cxt, size_t pos)
+{
+	if ( pos == 0 ) return 0 ;
+	const char *p = memchr(cxt->buf + pos - 1, cxt->sep, cxt->buf_len - pos + 1) ;
+	return p ? (size_t) (p - cxt->buf) + 1 : cxt->buf_len ;
+}
+
+static void count_job(void *arg, int job_idx)
+{
+	struct bulk_cxt *cxt = arg ;
+	struct bulk_job *j = &cxt->jobs[job_idx] ;
+	size_t count = 0 ;
+	for (const char *p = cxt->buf + j->begin, *end = cxt->buf + j->end ; p < end ; count++) {
+		const char *q = memchr(p, cxt->sep, end - p) ;
+		p = q ? q + 1 : end ;
+	}
+	j->count = count ;
+}
+
+static void parse_job(void *arg, int job_idx)
+{
+	struct bulk_cxt *cxt = arg ;
+	struct bulk_job *j = &cxt->jobs[job_idx] ;
+	size_t out = j->out_begin ;
+	for (const char *p = cxt->buf + j->begin, *end = cxt->buf + j->end ; p < end && out < cxt->values_max ; out++) {
+		const char *q = memchr(p, cxt->sep, end - p) ;
+		if ( !q ) q = end ;
+		enum_desc_idx idx = find_token(cxt->ed, p, q - p) ;
+		if ( idx == ENUM_DESC_NOT_FOUND ) {
+			cxt->values_out[out] = cxt->default_value ;
+			note_unknown(j, out) ;
+		} else {
+			cxt->values_out[out] = enum_desc_value_at(cxt->ed, idx) ;
+		}
+		p = q + 1 ;
+	}
+}
+
+size_t enum_refl_bulk_parse(enum_desc_t ed, const char *buf, size_t len, char sep,
+	enum_desc_val *values, size_t values_max, size_t *count_out,
+	enum_desc_val default_value, const struct enum_refl_bulk_opts *opts)
+{
+	int njobs = job_count(opts, len) ;
+	struct bulk_cxt cxt = {
+		.ed = ed, .opts = opts,
+		.buf = buf, .buf_len = len, .sep = sep,
+		.values_out = values, .values_max = values_max, .default_value = default_value,
+		.jobs = make_jobs(njobs, len),
+	} ;
+	if ( !cxt.jobs ) {
+		if ( count_out ) *count_out = 0 ;
+		return 0 ;
+	}
+	// Align chunk edges to token starts, so no token is split between jobs.
+	for (int i=1 ; i<njobs ; i++) {
+		cxt.jobs[i].begin = token_start(&cxt, cxt.jobs[i].begin) ;
+		cxt.jobs[i-1].end = cxt.jobs[i].begin ;
+	}
+	alloc_unknown(opts, cxt.jobs, njobs) ;
+	run_jobs(opts, njobs, count_job, &cxt) ;
+
+	size_t total = 0 ;
+	for (int i=0 ; i<njobs ; i++) {
+		cxt.jobs[i].out_begin = total ;
+		total += cxt.jobs[i].count ;
+	}
+	if ( count_out ) *count_out = total ;
+
+	run_jobs(opts, njobs, parse_job, &cxt) ;
+	return finish_jobs(opts, cxt.jobs, njobs) ;
+}
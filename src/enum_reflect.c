@@ -1,76 +1,199 @@
 #include "enum_refl.h"
 #include "enum_desc_def.h"
+#include "enum_desc_inline.h"
+#include "enum_desc_impl.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdatomic.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_AVX2_DISPATCH 1
+#endif
 
 const enum_desc_t enum_desc_null = &(struct enum_desc){
 	.strs = "enum_desc_null_enum\0\0\0\0\0\0\0\0",
 } ;
 
-static inline const char * desc_name(enum_desc_t ed) 
-{
-	return ed->strs ;
-}
-
-static inline int desc_value_count(enum_desc_t ed) 
-{
-	return ed->value_count ;
-}
+// Kernels shared with callers through enum_desc_inline.h
+static inline const char *desc_name(enum_desc_t ed) { return enum_desc_inline_name(ed) ; }
+static inline int desc_value_count(enum_desc_t ed) { return enum_desc_inline_value_count(ed) ; }
+static inline bool valid_index(enum_desc_t ed, enum_desc_idx idx) { return enum_desc_inline_valid_index(ed, idx) ; }
+static inline enum_desc_idx find_by_value(enum_desc_t ed, enum_desc_val value) { return enum_desc_inline_find_by_value(ed, value) ; }
+static inline bool is_valid(enum_desc_t ed, enum_desc_val value) { return enum_desc_inline_is_valid(ed, value) ; }
 
-static inline enum_desc_val value_at(enum_desc_t ed, enum_desc_idx idx) 
+// Labels of a trie-only descriptor, rebuilt on first use and shared by all threads:
+// uint32_t off[value_count] followed by the NUL terminated labels. NULL if out of memory.
+static const uint32_t *trie_labels(enum_desc_t ed)
 {
-	return ed->values[idx] ;
+	uint32_t *blob = __atomic_load_n((uint32_t **) ed->lbl_cache, __ATOMIC_ACQUIRE) ;
+	if ( blob ) return blob ;
+	int n = ed->value_count ;
+	size_t total = 0 ;
+	for (int i=0 ; i<n ; i++) total += enum_desc_trie_copy(ed->trie, i, NULL, 0) + 1 ;
+	blob = malloc(n * sizeof(*blob) + total) ;
+	if ( !blob ) return NULL ;
+	char *strs = (char *) (blob + n) ;
+	for (uint32_t i=0, off=0 ; i<n ; i++) {
+		blob[i] = off ;
+		off += enum_desc_trie_copy(ed->trie, i, strs + off, total - off) + 1 ;
+	}
+	void *expected = NULL ;
+	if ( !__atomic_compare_exchange_n(ed->lbl_cache, &expected, blob, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ) {
+		free(blob) ;            // another thread won
+		blob = expected ;
+	}
+	return blob ;
 }
 
 static inline const char * label_at(enum_desc_t ed, enum_desc_idx idx) 
 {
+	if ( ed->flags & ENUM_DESC_F_TRIE_LABELS ) {
+		const uint32_t *blob = trie_labels(ed) ;
+		return blob ? (const char *) (blob + ed->value_count) + blob[idx] : NULL ;
+	}
 	return ed->strs + ed->lbl_off[idx] ;
 }
 
 static inline enum_desc_idx find_by_label(enum_desc_t ed, const char *name)
 {
-	int name_len_p1 = strlen(name)+1 ;
+	if ( ed->trie ) return enum_desc_trie_find(ed->trie, name, strlen(name)) ;
 	const char *lbl_str = ed->strs ;
 	for (int i=0 ; i<ed->value_count ; i++) {
-		if ( !memcmp(lbl_str + ed->lbl_off[i], name, name_len_p1) ) return i ;
+		if ( !strcmp(lbl_str + ed->lbl_off[i], name) ) return i ;
 	}
 	return ENUM_DESC_NOT_FOUND ;
 }
 
-static inline enum_desc_idx find_by_value(enum_desc_t ed, enum_desc_val value) 
+static inline enum_desc_idx find_by_label_n(enum_desc_t ed, const char *name, size_t len)
 {
+	if ( ed->trie ) return enum_desc_trie_find(ed->trie, name, len) ;
+	const char *lbl_str = ed->strs ;
 	for (int i=0 ; i<ed->value_count ; i++) {
-		if ( ed->values[i] == value ) return i ;
+		const char *lbl = lbl_str + ed->lbl_off[i] ;
+		// name may hold NULs: the label must be exactly len bytes, compared as bytes.
+		if ( strnlen(lbl, len + 1) == len && !memcmp(lbl, name, len) ) return i ;
 	}
 	return ENUM_DESC_NOT_FOUND ;
 }
 
-static bool valid_index(enum_desc_t ed, enum_desc_idx idx) 
-{
-	return idx >=0 && idx < ed->value_count ;
-}
-
-
 //--------------------------------------------------------------------------------
 // Implementation of enum_desc functions
 //--------------------------------------------------------------------------------
 
-#define FLAG_DYNAMIC_ED (1<<0)
-
 enum_desc_idx enum_desc_find_by_label(enum_desc_t ed, const char *name) 
 {
 	return find_by_label(ed, name) ;
 }
 
+enum_desc_idx enum_desc_find_by_label_n(enum_desc_t ed, const char *name, size_t len)
+{
+	return find_by_label_n(ed, name, len) ;
+}
+
 enum_desc_idx enum_desc_find_by_value(enum_desc_t ed, enum_desc_val value) 
 {
 	return find_by_value(ed, value) ;
 }
 
+enum_desc_idx enum_desc_index_of_label_ptr(enum_desc_t ed, const char *label)
+{
+	int n = ed->value_count ;
+	if ( ed->flags & ENUM_DESC_F_TRIE_LABELS ) {
+		// Only materialized labels can be ours.
+		const uint32_t *blob = __atomic_load_n((uint32_t **) ed->lbl_cache, __ATOMIC_ACQUIRE) ;
+		uintptr_t off = blob ? (uintptr_t) label - (uintptr_t) (blob + n) : UINTPTR_MAX ;
+		if ( blob && n && off <= blob[n-1] ) {
+			int lo = 0, hi = n-1 ;
+			while ( lo < hi ) {
+				int mid = (lo + hi) / 2 ;
+				if ( blob[mid] < off ) lo = mid + 1 ; else hi = mid ;
+			}
+			if ( blob[lo] == off ) return lo ;
+		}
+		return find_by_label(ed, label) ;
+	}
+	uintptr_t off = (uintptr_t) label - (uintptr_t) ed->strs ;
+	if ( n && off >= ed->lbl_off[0] && off <= ed->lbl_off[n-1] ) {
+		int i ;
+		if ( ed->lbl_blk ) {
+			// At most 4 labels start in one block
+			for (i = ed->lbl_blk[off >> 3] ; ed->lbl_off[i] < off ; i++ ) ;
+		} else {
+			int lo = 0, hi = n-1 ;
+			while ( lo < hi ) {
+				int mid = (lo + hi) / 2 ;
+				if ( ed->lbl_off[mid] < off ) lo = mid + 1 ; else hi = mid ;
+			}
+			i = lo ;
+		}
+		if ( ed->lbl_off[i] == off ) return i ;
+	}
+	return find_by_label(ed, label) ;
+}
+
 const char * enum_desc_label_at(enum_desc_t ed, enum_desc_idx idx)
 {
 	if ( !valid_index(ed, idx) ) return NULL ;
-	return ed->strs + ed->lbl_off[idx];
+	return label_at(ed, idx) ;
+}
+
+int enum_desc_label_copy(enum_desc_t ed, enum_desc_idx idx, char *buf, size_t size)
+{
+	if ( !valid_index(ed, idx) ) return -1 ;
+	if ( ed->flags & ENUM_DESC_F_TRIE_LABELS ) return enum_desc_trie_copy(ed->trie, idx, buf, size) ;
+	const char *label = label_at(ed, idx) ;
+	size_t len = strlen(label) ;
+	if ( size ) {
+		size_t n = len < size ? len : size-1 ;
+		memcpy(buf, label, n) ;
+		buf[n] = 0 ;
+	}
+	return len ;
+}
+
+int enum_desc_label_set_count(enum_desc_t ed)
+{
+	return ed->label_sets ? ed->label_set_count : 0 ;
+}
+
+static inline const struct enum_desc_label_set *label_set(enum_desc_t ed, int set)
+{
+	return set >= 1 && set <= enum_desc_label_set_count(ed) ? &ed->label_sets[set-1] : NULL ;
+}
+
+const char *enum_desc_label_set_name(enum_desc_t ed, int set)
+{
+	const struct enum_desc_label_set *ls = label_set(ed, set) ;
+	return ls ? ls->strs : NULL ;
+}
+
+int enum_desc_label_set_find(enum_desc_t ed, const char *set_name)
+{
+	for (int set=1 ; set<=enum_desc_label_set_count(ed) ; set++)
+		if ( !strcmp(ed->label_sets[set-1].strs, set_name) ) return set ;
+	return -1 ;
+}
+
+const char *enum_desc_label_at_set(enum_desc_t ed, int set, enum_desc_idx idx)
+{
+	if ( set == 0 ) return enum_desc_label_at(ed, idx) ;
+	const struct enum_desc_label_set *ls = label_set(ed, set) ;
+	if ( !ls || !valid_index(ed, idx) ) return NULL ;
+	return ls->strs + ls->lbl_off[idx] ;
+}
+
+// Same route as the primary labels: trie when present, else a scan.
+enum_desc_idx enum_desc_find_by_label_set(enum_desc_t ed, int set, const char *label)
+{
+	if ( set == 0 ) return find_by_label(ed, label) ;
+	const struct enum_desc_label_set *ls = label_set(ed, set) ;
+	if ( !ls ) return ENUM_DESC_NOT_FOUND ;
+	if ( ls->trie ) return enum_desc_trie_find(ls->trie, label, strlen(label)) ;
+	// strcmp stops at the shorter string, memcmp could read past the last label
+	for (int i=0 ; i<ed->value_count ; i++) {
+		if ( !strcmp(ls->strs + ls->lbl_off[i], label) ) return i ;
+	}
+	return ENUM_DESC_NOT_FOUND ;
 }
 
 enum_desc_val enum_desc_value_at(enum_desc_t ed, enum_desc_idx idx)
@@ -81,8 +204,32 @@ enum_desc_val enum_desc_value_at(enum_desc_t ed, enum_desc_idx idx)
 
 void *enum_desc_meta_at(enum_desc_t ed, enum_desc_idx idx)
 {
-	if ( !valid_index(ed, idx) || !ed->meta ) return NULL ;
-	return ed->meta[idx] ;
+	return enum_desc_inline_meta_at(ed, idx) ;
+}
+
+int enum_desc_column_count(enum_desc_t ed)
+{
+	return ed->meta_info ? ed->meta_info->column_count : 0 ;
+}
+
+int enum_desc_column_find(enum_desc_t ed, const char *name)
+{
+	for (int col=0 ; col<enum_desc_column_count(ed) ; col++) {
+		if ( !strcmp(ed->meta_info->columns[col].name, name) ) return col ;
+	}
+	return -1 ;
+}
+
+const void *enum_desc_column_data(enum_desc_t ed, int col, size_t *size_out)
+{
+	if ( col < 0 || col >= enum_desc_column_count(ed) ) return NULL ;
+	if ( size_out ) *size_out = ed->meta_info->columns[col].size ;
+	return ed->meta_info->columns[col].data ;
+}
+
+const void *enum_desc_column_at(enum_desc_t ed, int col, enum_desc_idx idx)
+{
+	return enum_desc_inline_column_at(ed, col, idx) ;
 }
 
 const char *enum_desc_name(enum_desc_t ed)
@@ -95,6 +242,90 @@ int enum_desc_value_count(enum_desc_t ed)
 	return desc_value_count(ed) ;
 }
 
+int enum_desc_aliases_of(enum_desc_t ed, enum_desc_val value, enum_desc_idx *idx_out, int max)
+{
+	int n = 0 ;
+	if ( !ed->by_value ) {
+		// No index: duplicates are not known up front, collect them all.
+		for (int i=0 ; i<ed->value_count ; i++) {
+			if ( ed->values[i] != value ) continue ;
+			if ( n < max ) idx_out[n] = i ;
+			n++ ;
+		}
+		return n ;
+	}
+	for (enum_desc_idx i = find_by_value(ed, value) ; i != ENUM_DESC_NOT_FOUND ; i = ed->alias_next ? ed->alias_next[i] : ENUM_DESC_NOT_FOUND) {
+		if ( n < max ) idx_out[n] = i ;
+		n++ ;
+	}
+	return n ;
+}
+
+bool enum_desc_is_valid(enum_desc_t ed, enum_desc_val value)
+{
+	return is_valid(ed, value) ;
+}
+
+// Bitmap validation, 8 values per step, no branches inside a block.
+// Returns the start of the first block with an invalid value, or the tail.
+static size_t validate_bits(enum_desc_t ed, const enum_desc_val *vals, size_t n)
+{
+	const uint32_t *bits = ed->value_bits ;
+	uint32_t min = ed->value_min ;
+	uint32_t span = (uint32_t) ed->value_max - min ;
+	size_t i = 0 ;
+	for ( ; i + 8 <= n ; i += 8 ) {
+		uint32_t ok = 1 ;
+		for (int k=0 ; k<8 ; k++) {
+			uint32_t off = (uint32_t) vals[i+k] - min ;
+			uint32_t in = off <= span ;
+			ok &= in & (bits[in ? off >> 5 : 0] >> (off & 31)) ;
+		}
+		if ( !ok ) break ;
+	}
+	return i ;
+}
+
+#if HAVE_AVX2_DISPATCH
+__attribute__((target("avx2")))
+static size_t validate_bits_avx2(enum_desc_t ed, const enum_desc_val *vals, size_t n)
+{
+	const int *bits = (const int *) ed->value_bits ;
+	const __m256i vmin = _mm256_set1_epi32(ed->value_min) ;
+	const __m256i vspan = _mm256_set1_epi32((uint32_t) ed->value_max - (uint32_t) ed->value_min) ;
+	const __m256i one = _mm256_set1_epi32(1) ;
+	const __m256i m31 = _mm256_set1_epi32(31) ;
+	size_t i = 0 ;
+	for ( ; i + 8 <= n ; i += 8 ) {
+		__m256i off = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *) (vals + i)), vmin) ;
+		__m256i in = _mm256_cmpeq_epi32(_mm256_max_epu32(off, vspan), vspan) ;     // off <= span, unsigned
+		__m256i word = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), bits, _mm256_srli_epi32(off, 5), in, 4) ;
+		__m256i bit = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(off, m31)), one) ;
+		if ( _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(bit, one))) != 0xff ) break ;
+	}
+	return i ;
+}
+#endif
+
+bool enum_desc_validate(enum_desc_t ed, const enum_desc_val *vals, size_t n, size_t *bad_idx_out)
+{
+	size_t i = 0 ;
+	if ( (ed->flags & ENUM_DESC_F_RANGE) && ed->value_bits ) {
+#if HAVE_AVX2_DISPATCH
+		i = __builtin_cpu_supports("avx2") ? validate_bits_avx2(ed, vals, n) : validate_bits(ed, vals, n) ;
+#else
+		i = validate_bits(ed, vals, n) ;
+#endif
+	}
+	for ( ; i<n ; i++ ) {
+		if ( !is_valid(ed, vals[i]) ) {
+			if ( bad_idx_out ) *bad_idx_out = i ;
+			return false ;
+		}
+	}
+	return true ;
+}
+
 //--------------------------------------------------------------------------------
 // Implementation of enum_desc functions
 //--------------------------------------------------------------------------------
@@ -107,13 +338,67 @@ int enum_refl_value_count(enum_desc_t ed) {
 	return desc_value_count(ed) ;
 }
 
-enum_desc_idx enum_refl_find_by_value(enum_desc_t ed, enum_desc_val value)
+//--------------------------------------------------------------------------------
+// Per-thread lookup cache for enum_refl_find_by_value (opt-in, per thread).
+// Direct mapped on (ed, value), tagged with the descriptor's generation: a
+// descriptor built at a freed one's address has a new generation, so destroy
+// drops nothing and a stale entry simply misses. Static descriptors are never freed.
+//--------------------------------------------------------------------------------
+
+#ifndef ENUM_REFL_CACHE_SLOTS
+#define ENUM_REFL_CACHE_SLOTS 64        // power of 2
+#endif
+
+struct cache_slot {
+	enum_desc_t ed ;
+	enum_desc_val value ;
+	enum_desc_idx idx ;
+	uint32_t generation ;
+} ;
+
+static atomic_uint desc_generation ;
+static _Thread_local bool cache_on ;
+static _Thread_local struct enum_refl_cache_stats cache_stats ;
+static _Thread_local struct cache_slot cache_slots[ENUM_REFL_CACHE_SLOTS] ;
+
+void enum_refl_cache_enable(bool enable)
+{
+	cache_on = enable ;
+}
+
+void enum_refl_cache_stats(struct enum_refl_cache_stats *stats, bool reset)
+{
+	if ( stats ) *stats = cache_stats ;
+	if ( reset ) cache_stats = (struct enum_refl_cache_stats) { 0 } ;
+}
+
+static inline enum_desc_idx lookup_by_value(enum_desc_t ed, enum_desc_val value)
 {
 	enum_desc_ext_t ext = ed->ext ;
 	if ( ext && ext->find_by_value) return ext->find_by_value(ed, value) ;
 	return find_by_value(ed, value) ;
 }
 
+static enum_desc_idx cached_find_by_value(enum_desc_t ed, enum_desc_val value)
+{
+	uint32_t h = ((uint32_t) ((uintptr_t) ed >> 4) ^ (uint32_t) value) * 0x9E3779B1u ;
+	struct cache_slot *slot = &cache_slots[h >> 16 & (ENUM_REFL_CACHE_SLOTS-1)] ;
+	if ( slot->ed == ed && slot->value == value && slot->generation == ed->generation ) {
+		cache_stats.hits++ ;
+		return slot->idx ;
+	}
+	cache_stats.misses++ ;
+	enum_desc_idx idx = lookup_by_value(ed, value) ;
+	*slot = (struct cache_slot) { .ed = ed, .value = value, .idx = idx, .generation = ed->generation } ;
+	return idx ;
+}
+
+enum_desc_idx enum_refl_find_by_value(enum_desc_t ed, enum_desc_val value)
+{
+	if ( cache_on ) return cached_find_by_value(ed, value) ;
+	return lookup_by_value(ed, value) ;
+}
+
 enum_desc_idx enum_refl_find_by_label(enum_desc_t ed, const char *name)
 {
 	enum_desc_ext_t ext = ed->ext ;
@@ -137,7 +422,19 @@ const char * enum_refl_label_at(enum_desc_t ed, enum_desc_idx idx)
 
 void *enum_refl_meta_at(enum_desc_t ed, enum_desc_idx idx) 
 {
-	return valid_index(ed, idx) && ed->meta ? ed->meta[idx] : NULL ;
+	return enum_desc_inline_meta_at(ed, idx) ;
+}
+
+void *enum_refl_meta_of(enum_desc_t ed, enum_desc_val value)
+{
+	if ( !ed->meta ) return NULL ;
+	return enum_desc_inline_meta_at(ed, enum_refl_find_by_value(ed, value)) ;
+}
+
+const void *enum_refl_column_of(enum_desc_t ed, int col, enum_desc_val value)
+{
+	if ( col < 0 || col >= enum_desc_column_count(ed) ) return NULL ;
+	return enum_desc_inline_column_at(ed, col, enum_refl_find_by_value(ed, value)) ;
 }
 
 enum_desc_val enum_refl_value_of(enum_desc_t ed, const char *label, enum_desc_val default_value)
@@ -177,52 +474,300 @@ static const struct enum_desc_ext enum_desc_dynamic_ext = {
 } ;
 
 
+struct value_pos {
+	enum_desc_val value ;
+	enum_desc_idx idx ;
+} ;
+
+static int cmp_value_pos(const void *a, const void *b)
+{
+	const struct value_pos *x = a, *y = b ;
+	if ( x->value != y->value ) return x->value < y->value ? -1 : 1 ;
+	return x->idx - y->idx ;
+}
+
+// Fill by_value with the first index of each distinct value, sorted by value.
+// Returns the alias chain, NULL when all values are distinct.
+static enum_desc_idx *build_value_index(struct enum_desc_arena *arena, const enum_desc_val *values, int count, enum_desc_idx *by_value, int *uniq_count)
+{
+	struct value_pos *vp = calloc(count+1, sizeof(*vp)) ;
+	for (int i=0 ; i<count ; i++) vp[i] = (struct value_pos) { values[i], i } ;
+	qsort(vp, count, sizeof(*vp), cmp_value_pos) ;
+
+	enum_desc_idx *alias_next = NULL ;
+	int n = 0 ;
+	for (int i=0 ; i<count ; i++) {
+		if ( i > 0 && vp[i].value == vp[i-1].value ) {
+			if ( !alias_next ) {
+				alias_next = enum_desc_alloc(arena, count, sizeof(*alias_next)) ;
+				for (int k=0 ; k<count ; k++) alias_next[k] = ENUM_DESC_NOT_FOUND ;
+			}
+			alias_next[vp[i-1].idx] = vp[i].idx ;
+			continue ;
+		}
+		by_value[n++] = vp[i].idx ;
+	}
+	free(vp) ;
+	*uniq_count = n ;
+	return alias_next ;
+}
+
+struct label_pos {
+	const char *label ;
+	enum_desc_idx idx ;
+} ;
+
+static int cmp_label_pos(const void *a, const void *b)
+{
+	const struct label_pos *x = a, *y = b ;
+	int c = strcmp(x->label, y->label) ;
+	return c ? c : x->idx - y->idx ;
+}
+
+// Every index sorted by label, for enum_desc_iter_sorted.
+static enum_desc_idx *build_label_order(struct enum_desc_arena *arena, const struct enum_desc_entry entries[], int count)
+{
+	struct label_pos *lp = calloc(count+1, sizeof(*lp)) ;
+	for (int i=0 ; i<count ; i++) lp[i] = (struct label_pos) { entries[i].name, i } ;
+	qsort(lp, count, sizeof(*lp), cmp_label_pos) ;
+	enum_desc_idx *by_label = enum_desc_alloc(arena, count+1, sizeof(*by_label)) ;
+	for (int i=0 ; i<count ; i++) by_label[i] = lp[i].idx ;
+	free(lp) ;
+	return by_label ;
+}
+
 enum_desc_t enum_refl_build(const char *name, struct enum_desc_entry entries[], enum_desc_ext_t ext)
 {
+	return enum_refl_build_in(NULL, name, entries, ext) ;
+}
+
+enum_desc_t enum_refl_build_in(enum_desc_arena_t arena, const char *name, struct enum_desc_entry entries[], enum_desc_ext_t ext)
+{
+	return enum_refl_build_with(arena, name, entries, ext, NULL) ;
+}
+
+// Set name then labels, same layout as the primary strs.
+static struct enum_desc_label_set *build_label_sets(struct enum_desc_arena *arena, int count, const struct enum_desc_label_set_def *defs, int set_count)
+{
+	struct enum_desc_label_set *sets = enum_desc_alloc(arena, set_count, sizeof(*sets)) ;
+	for (int k=0 ; k<set_count ; k++) {
+		size_t strs_len = strlen(defs[k].name)+1 + 8 ;
+		for (int i=0 ; i<count ; i++) strs_len += strlen(defs[k].labels[i])+1 ;
+		char *strs = enum_desc_alloc(arena, strs_len, 1) ;
+		uint16_t *lbl_off = enum_desc_alloc(arena, count+1, sizeof(*lbl_off)) ;
+		const char **labels = calloc(count+1, sizeof(*labels)) ;
+		strcpy(strs, defs[k].name) ;
+		size_t off = strlen(strs)+1 ;
+		for (int i=0 ; i<count ; i++) {
+			lbl_off[i] = off ;
+			labels[i] = strcpy(strs + off, defs[k].labels[i]) ;
+			off += strlen(labels[i])+1 ;
+		}
+		sets[k] = (struct enum_desc_label_set) {
+			.strs = strs,
+			.lbl_off = lbl_off,
+			.trie = count >= ENUM_DESC_TRIE_MIN_COUNT ? enum_desc_trie_build(arena, labels, count, strs) : NULL,
+		} ;
+		free(labels) ;
+	}
+	return sets ;
+}
+
+// Meta goes sparse when the packed array, bitmap and rank take less than the full array.
+static void **build_meta(struct enum_desc_arena *arena, const struct enum_desc_entry entries[], int count, int meta_count,
+	struct enum_desc_meta *mi)
+{
+	int words = (count + 31) / 32 ;
+	size_t sparse_bytes = meta_count * sizeof(void *) + words * (sizeof(*mi->bits) + sizeof(*mi->rank)) ;
+	bool sparse = sparse_bytes < count * sizeof(void *) ;
+	void **meta = enum_desc_alloc(arena, (sparse ? meta_count : count) + 1, sizeof(*meta)) ;
+	if ( !sparse ) {
+		for (int i=0 ; i<count ; i++) meta[i] = entries[i].meta ;
+		return meta ;
+	}
+	uint32_t *bits = enum_desc_alloc(arena, words, sizeof(*bits)) ;
+	uint16_t *rank = enum_desc_alloc(arena, words, sizeof(*rank)) ;
+	for (int i=0, n=0 ; i<count ; i++) {
+		if ( !entries[i].meta ) continue ;
+		bits[i >> 5] |= 1u << (i & 31) ;
+		meta[n++] = entries[i].meta ;
+	}
+	for (int w=1 ; w<words ; w++) rank[w] = rank[w-1] + __builtin_popcount(bits[w-1]) ;
+	mi->bits = bits ;
+	mi->rank = rank ;
+	return meta ;
+}
+
+static struct enum_desc_column *build_columns(struct enum_desc_arena *arena, int count, const struct enum_desc_column_def *defs, int column_count)
+{
+	struct enum_desc_column *cols = enum_desc_alloc(arena, column_count, sizeof(*cols)) ;
+	for (int k=0 ; k<column_count ; k++) {
+		char *name = enum_desc_alloc(arena, strlen(defs[k].name)+1, 1) ;
+		void *data = enum_desc_alloc(arena, count+1, defs[k].size) ;
+		memcpy(data, defs[k].data, count * defs[k].size) ;
+		cols[k] = (struct enum_desc_column) {
+			.name = strcpy(name, defs[k].name),
+			.size = defs[k].size,
+			.data = data,
+		} ;
+	}
+	return cols ;
+}
+
+enum_desc_t enum_refl_build_sets(enum_desc_arena_t arena, const char *name, struct enum_desc_entry entries[], enum_desc_ext_t ext,
+	const struct enum_desc_label_set_def *sets, int set_count)
+{
+	struct enum_refl_build_opts opts = { .sets = sets, .set_count = set_count } ;
+	return enum_refl_build_with(arena, name, entries, ext, &opts) ;
+}
+
+enum_desc_t enum_refl_build_with(enum_desc_arena_t arena, const char *name, struct enum_desc_entry entries[], enum_desc_ext_t ext,
+	const struct enum_refl_build_opts *opts)
+{
+	static const struct enum_refl_build_opts no_opts ;
+	if ( !opts ) opts = &no_opts ;
 	int count = 0 ;
-	int strs_len = strlen(name)+1 ; // include enum name
-	bool has_meta = false ;
+	int lbl_bytes = 0 ;
+	int meta_count = 0 ;
+	enum_desc_val value_min = entries[0].value, value_max = entries[0].value ;
 	while ( entries[count].name) {
-		if ( entries[count].meta ) has_meta = true ;
-		strs_len += strlen(entries[count].name)+1 ;
+		if ( entries[count].meta ) meta_count++ ;
+		if ( entries[count].value < value_min ) value_min = entries[count].value ;
+		if ( entries[count].value > value_max ) value_max = entries[count].value ;
+		lbl_bytes += strlen(entries[count].name)+1 ;
 		count++ ;
 	}
-	strs_len+=2 ;
-	char *strs = calloc(strs_len + _Alignof(max_align_t), 1) ;
+	// Header first, the arrays follow it in the arena.
+	struct enum_desc *ed = enum_desc_alloc(arena, 1, sizeof(*ed)) ;
+	// Large label sets are kept only in the trie, edges shared by common prefixes.
+	const char **labels = calloc(count+1, sizeof(*labels)) ;
+	for (int i=0 ; i<count ; i++) labels[i] = entries[i].name ;
+	struct enum_desc_trie *trie = NULL ;
+	if ( count >= ENUM_DESC_TRIE_MIN_COUNT && lbl_bytes >= ENUM_DESC_TRIE_LABELS_MIN_BYTES )
+		trie = enum_desc_trie_build(arena, labels, count, NULL) ;
+	bool trie_only = trie != NULL ;
+
+	int strs_len = strlen(name)+1 + (trie_only ? 0 : lbl_bytes) + 2 ; // include enum name
+	char *strs = enum_desc_alloc(arena, strs_len + _Alignof(max_align_t), 1) ;
 	strcpy(strs, name) ;
 	int off = strlen(name)+1 ;
-	enum_desc_val *values = calloc(count+1, sizeof(*values)) ;
-	uint16_t *label_off = calloc(count+1, sizeof(*label_off)) ;
-	void **meta = has_meta ? calloc(count+1, sizeof(*meta)) : NULL ;
+	enum_desc_val *values = enum_desc_alloc(arena, count+1, sizeof(*values)) ;
+	uint16_t *label_off = trie_only ? NULL : enum_desc_alloc(arena, count+1, sizeof(*label_off)) ;
+	struct enum_desc_meta *meta_info = NULL ;
+	if ( meta_count || opts->column_count > 0 ) meta_info = enum_desc_alloc(arena, 1, sizeof(*meta_info)) ;
+	void **meta = meta_count ? build_meta(arena, entries, count, meta_count, meta_info) : NULL ;
+	if ( opts->column_count > 0 ) {
+		meta_info->column_count = opts->column_count ;
+		meta_info->columns = build_columns(arena, count, opts->columns, opts->column_count) ;
+	}
 
 	for(int i=0; i<count ; i++ ) {
 		struct enum_desc_entry *e = &entries[i] ;
-		label_off[i] = off ;
 		values[i] = e->value ;
-		if ( meta ) meta[i] = e->meta ;
+		if ( trie_only ) continue ;
+		label_off[i] = off ;
+		labels[i] = strs + off ;
 		strcpy(strs + off, e->name) ;
 		off += strlen(strs+off)+1 ;
 	}
-	struct enum_desc *ed = calloc(1, sizeof(*ed)) ;
+	if ( !trie_only && count >= ENUM_DESC_TRIE_MIN_COUNT )
+		trie = enum_desc_trie_build(arena, labels, count, strs) ;
+	free(labels) ;
+	uint32_t *value_bits = NULL ;
+	uint16_t *value_rank = NULL ;
+	uint32_t bits_words = ((uint64_t) value_max - value_min) / 32 + 1 ;
+	if ( count && bits_words <= ENUM_DESC_BITMAP_WORDS_MAX(count) ) {
+		value_bits = enum_desc_alloc(arena, bits_words, sizeof(*value_bits)) ;
+		value_rank = enum_desc_alloc(arena, bits_words, sizeof(*value_rank)) ;
+		for (int i=0; i<count ; i++ ) {
+			uint32_t off = (uint32_t) values[i] - (uint32_t) value_min ;
+			value_bits[off >> 5] |= 1u << (off & 31) ;
+		}
+		for (uint32_t w=1 ; w<bits_words ; w++ )
+			value_rank[w] = value_rank[w-1] + __builtin_popcount(value_bits[w-1]) ;
+	}
+	int blk_count = count && label_off ? (label_off[count-1] >> 3) + 1 : 0 ;
+	enum_desc_idx *lbl_blk = enum_desc_alloc(arena, blk_count+1, sizeof(*lbl_blk)) ;
+	for (int b=0, i=0 ; b<blk_count ; b++) {
+		while ( label_off[i] < b*8 ) i++ ;
+		lbl_blk[b] = i ;
+	}
+	int uniq_count = 0 ;
+	enum_desc_idx *by_value = enum_desc_alloc(arena, count+1, sizeof(*by_value)) ;
+	enum_desc_idx *alias_next = build_value_index(arena, values, count, by_value, &uniq_count) ;
 	*ed = (struct enum_desc) {
 //		.name = name,
-		.flags = FLAG_DYNAMIC_ED,
+		.flags = ENUM_DESC_F_DYNAMIC | (count ? ENUM_DESC_F_RANGE : 0) | (trie_only ? ENUM_DESC_F_TRIE_LABELS : 0)
+			| (arena ? ENUM_DESC_F_ARENA : 0),
+		.generation = atomic_fetch_add_explicit(&desc_generation, 1, memory_order_relaxed) + 1,
 		.value_count = count,
 		.values = values,
 		.strs = strs,
 		.lbl_off = label_off,
 		.meta = meta,
 		.ext = ext ?: &enum_desc_dynamic_ext,
+		.value_min = value_min,
+		.value_max = value_max,
+		.value_bits = value_bits,
+		.value_rank = value_rank,
+		.uniq_count = uniq_count,
+		.by_value = by_value,
+		.alias_next = alias_next,
+		.lbl_blk = lbl_blk,
+		.trie = trie,
+		.lbl_cache = trie_only ? enum_desc_alloc(arena, 1, sizeof(void *)) : NULL,
+		.label_set_count = opts->set_count,
+		.label_sets = opts->set_count > 0 ? build_label_sets(arena, count, opts->sets, opts->set_count) : NULL,
+		.meta_info = meta_info,
+		.by_label = build_label_order(arena, entries, count),
+		.fingerprint = enum_desc_fingerprint_of(name, entries, count),
 	};
+	if ( arena ) enum_desc_arena_add(arena, ed) ;
 	return ed ;
 }
 
-void enum_desc_destroy(enum_desc_t ed)
+// Teardown shared by enum_desc_destroy and enum_desc_arena_release.
+void enum_desc_release_state(enum_desc_t ed)
 {
 	enum_desc_ext_t ext = ed->ext ;
 	if ( ext && ext->destroy ) ext->destroy(ed) ;
-	if ( ed->flags && FLAG_DYNAMIC_ED ) {
+	if ( (ed->flags & ENUM_DESC_F_DYNAMIC) && ed->lbl_cache ) free(*ed->lbl_cache) ;
+}
+
+void enum_desc_destroy(enum_desc_t ed)
+{
+	if ( ed->flags & ENUM_DESC_F_ARENA ) return ;       // freed with the arena
+	if ( ed->flags & ENUM_DESC_F_INTERNED ) {            // shared, the last reference frees it
+		enum_desc_intern_release(ed) ;
+		return ;
+	}
+	enum_desc_release_state(ed) ;
+	if ( ed->flags & ENUM_DESC_F_DYNAMIC ) {
 		free((void *) ed->values) ;
+		free((void *) ed->value_bits) ;
+		free((void *) ed->value_rank) ;
+		free((void *) ed->by_value) ;
+		free((void *) ed->by_label) ;
+		free((void *) ed->alias_next) ;
+		free((void *) ed->lbl_blk) ;
+		enum_desc_trie_free(ed->trie, ed->flags & ENUM_DESC_F_TRIE_LABELS) ;
+		free(ed->lbl_cache) ;
+		for (int k=0 ; k<enum_desc_label_set_count(ed) ; k++) {
+			enum_desc_trie_free(ed->label_sets[k].trie, false) ;
+			free((void *) ed->label_sets[k].lbl_off) ;
+			free((void *) ed->label_sets[k].strs) ;
+		}
+		free((void *) ed->label_sets) ;
+		if ( ed->meta_info ) {
+			for (int k=0 ; k<ed->meta_info->column_count ; k++) {
+				free((void *) ed->meta_info->columns[k].name) ;
+				free((void *) ed->meta_info->columns[k].data) ;
+			}
+			free((void *) ed->meta_info->columns) ;
+			free((void *) ed->meta_info->bits) ;
+			free((void *) ed->meta_info->rank) ;
+			free((void *) ed->meta_info) ;
+		}
 		free((void *) ed->lbl_off) ;
 		free((void *) ed->strs) ;
 		free((ed->meta)) ;
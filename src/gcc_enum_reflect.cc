@@ -2,11 +2,31 @@
  * gcc_enum_reflect.cc  (GCC 13+)
  *
  * - Records enums passed to enum_reflect(x) (x must be enum-typed expression)
+ *   and enums declared with __attribute__((enum_reflect)); the latter get a
+ *   public __enum_desc__<E> in a comdat group, see ENUM_DESC_REF()
+ * - C and C++: scoped enums, namespaces, enums in class templates. Symbols use
+ *   the qualified name ("ns::box<int>::state" -> ns__box_int___state), with a
+ *   numeric suffix if two enums still map to the same symbol.
  * - At end of translation unit, emits:
- *     __enum_lblstr_<E>  (char blob: "A\0B\0...\0" + 8 NUL)
- *     __enum_lbloff_<E>  (uint16 offsets into lblstr)
- *     __enum_vals_<E>    (int values)
- *     __enum_desc_<E>    (const struct enum_desc, using the real type from headers)
+ *     __enum_pack_<E>    (64 byte aligned, one object, in this order:)
+ *       hdr              (const struct enum_desc, using the real type from headers)
+ *       vals             (int values)
+ *       lbloff           (uint16 offsets into lblstr)
+ *       lblstr           (char blob: "A\0B\0...\0" + 8 NUL)
+ *       valbits          (uint32 bitmap over [min, max], skipped for wide ranges)
+ *       valrank          (uint16 set bits before each bitmap word)
+ *       byval            (first index of each distinct value, sorted by value)
+ *     __enum_alias_<E>   (next index with the same value, only if values repeat)
+ *     __enum_lblblk_<E>  (per 8 bytes of lblstr: first label starting there or later)
+ *     __enum_bylabel_<E> (every index sorted by label)
+ *     __enum_trie*_<E>   (label radix trie, from trie-min= items; edges point into
+ *                         lblstr, or into __enum_trieseg_<E> when the labels take at
+ *                         least trie-labels-min= bytes and are kept only in the trie)
+ *     __enum_lblcache_<E> (writable slot for labels rebuilt from a trie-only desc)
+ *     __enum_lsets_<E>   (extra label sets from label-set= args, each with its
+ *                         __enum_lsetstr<k>_<E>, __enum_lsetoff<k>_<E> and trie)
+ *     __enum_desc__<E>   (alias of the pack header, public for attributed enums)
+ *     __enum_reg_<E>     (pointer to the desc in section enum_desc_reg)
  *
  * Build:
  *   g++ -shared -fPIC -O2 -fno-lto -fno-rtti -fno-exceptions \
@@ -14,6 +34,7 @@
  *     -I"$(gcc -print-file-name=plugin)/include"
  */
 
+#define INCLUDE_ALGORITHM   // std::stable_sort, must come before system.h
 #include "gcc-plugin.h"
 #include "plugin-version.h"
 
@@ -26,10 +47,14 @@
 #include "tree-pass.h"
 #include "basic-block.h"
 #include "diagnostic.h"
+#include "attribs.h"
 
 #include "cgraph.h"
 #include "varasm.h"
 #include "stor-layout.h"
+#include "langhooks.h"
+#include "tree-iterator.h"
+#include "cp/cp-tree.h"     // template info macros, read on C++ trees only
 
 #include "hash-set.h"
 #include "hash-map.h"
@@ -56,39 +81,173 @@ static struct enum_desc_fields {
     tree f_value_count;
     tree f_lbl_off;
     tree f_values;
+    // optional, older headers may not have them
+    tree f_flags;
+    tree f_value_min;
+    tree f_value_max;
+    tree f_value_bits;
+    tree f_value_rank;
+    tree f_uniq_count;
+    tree f_by_value;
+    tree f_alias_next;
+    tree f_lbl_blk;
+    tree f_trie;
+    tree f_lbl_cache;
+    tree f_label_set_count;
+    tree f_label_sets;
+    tree f_by_label;
+    tree f_fingerprint;
 } g_enum_desc_fields;
 
+/* Must match include/enum_desc_def.h */
+#define ENUM_DESC_F_RANGE (1<<1)
+#define ENUM_DESC_F_TRIE_LABELS (1<<2)
+#define ENUM_DESC_BITMAP_WORDS_MAX(count) ((count) + 64)
+#define ENUM_DESC_TRIE_MIN_COUNT 8
+#define ENUM_DESC_TRIE_LABELS_MIN_BYTES 4096
+
+/* Plugin args trie-min= and trie-labels-min= */
+static size_t g_trie_min_count = ENUM_DESC_TRIE_MIN_COUNT;
+static size_t g_trie_labels_min_bytes = ENUM_DESC_TRIE_LABELS_MIN_BYTES;
+
+/* Plugin arg label-set=<name>:<transform>[+<transform>...], repeatable.
+   Transforms run in order: strip-prefix (common prefix up to its last '_'), lower, upper. */
+enum { LSET_STRIP_PREFIX, LSET_LOWER, LSET_UPPER };
+struct label_set_spec {
+    std::string name;
+    std::vector<int> transforms;
+};
+static std::vector<label_set_spec> g_label_sets;
+
 static hash_set<tree> g_seen_enums;           /* ENUMERAL_TYPE nodes to emit */
+static std::vector<tree> g_enum_order;        /* same, in discovery order */
+static std::map<tree, tree> g_enumtype_to_descvar;
+static hash_set<tree> g_public_enums;         /* __attribute__((enum_reflect)): public descriptor */
+
+/* Display name (stored in the blob) and unique symbol suffix per enum */
+struct enum_names {
+    std::string display;
+    std::string sym;
+    bool suffixed = false;      /* sym got a suffix to stay unique in the unit */
+};
+static std::map<tree, enum_names> g_enum_names;
+static std::map<std::string, int> g_sym_used;
+
+/* C++ template patterns: t is, or is nested in, a class or function template
+   that is not an instantiation (dependent enums, members of class templates).
+   Only tree fields are read, no cc1plus functions, so cc1 can load the plugin. */
+static bool in_template_pattern(tree t)
+{
+    if (!lang_GNU_CXX())
+        return false;
+    while (t && TREE_CODE(t) != TRANSLATION_UNIT_DECL && TREE_CODE(t) != NAMESPACE_DECL)
+    {
+        if (TREE_CODE(t) == FUNCTION_DECL)
+        {
+            if (DECL_LANG_SPECIFIC(t) && DECL_TEMPLATE_INFO(t) && !DECL_USE_TEMPLATE(t))
+                return true;
+        }
+        else if (CLASS_TYPE_P(t) && TYPE_LANG_SPECIFIC(t))
+        {
+            if (CLASSTYPE_TEMPLATE_INFO(t) && !CLASSTYPE_USE_TEMPLATE(t))
+                return true;
+        }
+        t = TYPE_P(t) ? TYPE_CONTEXT(t) : DECL_CONTEXT(t);
+    }
+    return false;
+}
 
 static const char *kReflectFnName = "enum_desc_gen";  // magic function to expand
+static tree g_reflect_id;           /* its identifier, decls are matched by pointer */
+static bool g_reflect_declared;     /* the unit declares enum_desc_gen, nothing to find until then */
+
+/* Detection work, printed at the end with the stats plugin arg */
+struct detect_stats {
+    unsigned long fe_functions;     /* bodies walked for wrapper rewrites */
+    unsigned long functions;        /* functions whose call edges were scanned */
+    unsigned long call_edges;
+    unsigned long sites;            /* calls to enum_desc_gen */
+};
+static detect_stats g_stats;
+static bool g_print_stats;
 
 /* ------------------------------------------------------------ */
 /* Small helpers */
 
-static const char *type_name_cstr(tree t)
+/* Qualified name: "color" in C, "ns::outer<int>::color" in C++ (via the front-end printer) */
+static std::string enum_display_name(tree t)
 {
-    if (!t) return "<null>";
-
     tree tn = TYPE_NAME(t);
-    if (!tn) return "<anonymous>";
+    if (tn && TREE_CODE(tn) == TYPE_DECL && DECL_NAME(tn))
+    {
+        const char *nm = lang_GNU_CXX() ? lang_hooks.decl_printable_name(tn, 2)
+                                        : IDENTIFIER_POINTER(DECL_NAME(tn));
+        if (nm && *nm) return nm;
+    }
+    if (tn && TREE_CODE(tn) == IDENTIFIER_NODE)
+        return IDENTIFIER_POINTER(tn);
+    return "<anonymous>";
+}
 
-    if (TREE_CODE(tn) == TYPE_DECL)
+/* Names are fixed on first sight, so suffixes for clashing names follow source order */
+static const enum_names &enum_names_for(tree enum_type)
+{
+    auto it = g_enum_names.find(enum_type);
+    if (it != g_enum_names.end())
+        return it->second;
+
+    enum_names nm;
+    nm.display = enum_display_name(enum_type);
+
+    // "ns::box<int>::state" -> "ns__box_int___state"
+    std::string base;
+    for (size_t i = 0; i < nm.display.size(); i++)
+    {
+        char c = nm.display[i];
+        if (c == ':' && i+1 < nm.display.size() && nm.display[i+1] == ':')
+        {
+            base += "__";
+            i++;
+        }
+        else
+            base += ISALNUM(c) ? c : '_';
+    }
+    if (base.empty() || nm.display == "<anonymous>")
+        base = "anon";
+
+    nm.sym = base;
+    int n = g_sym_used[base]++;
+    if (n > 0)
     {
-        tree id = DECL_NAME(tn);
-        return id ? IDENTIFIER_POINTER(id) : "<anonymous>";
+        nm.sym += "_" + std::to_string(n);
+        nm.suffixed = true;
     }
+    return g_enum_names.emplace(enum_type, nm).first->second;
+}
 
-    if (TREE_CODE(tn) == IDENTIFIER_NODE)
-        return IDENTIFIER_POINTER(tn);
+/* Remember an enum for emission at end of unit */
+static void note_enum(tree enum_type)
+{
+    if (g_seen_enums.add(enum_type))
+        return;
+    enum_names_for(enum_type);
+    g_enum_order.push_back(enum_type);
+}
 
-    return "<anonymous>";
+/* Enum declared with __attribute__((enum_reflect)): emitted even without a wrapper,
+   under the public name __enum_desc__<sym> */
+static void note_public_enum(tree enum_type)
+{
+    enum_type = TYPE_MAIN_VARIANT(enum_type);
+    if (in_template_pattern(enum_type))
+        return;
+    g_public_enums.add(enum_type);
+    note_enum(enum_type);
 }
 
-static const char *fndecl_name_cstr(tree fndecl)
+static inline bool is_reflect_fn(tree fndecl)
 {
-    if (!fndecl || TREE_CODE(fndecl) != FUNCTION_DECL) return nullptr;
-    tree id = DECL_NAME(fndecl);
-    return id ? IDENTIFIER_POINTER(id) : nullptr;
+    return fndecl && TREE_CODE(fndecl) == FUNCTION_DECL && DECL_NAME(fndecl) == g_reflect_id;
 }
 
 static tree make_u16_type()
@@ -102,6 +261,13 @@ static tree make_u16_type()
 #endif
 }
 
+static tree make_u32_type()
+{
+    static tree t = nullptr;
+    if (!t) t = build_nonstandard_integer_type(32, /*unsigned=*/1);
+    return t;
+}
+
 static tree ptr_to_first_elem(tree array_expr, tree desired_ptr_type)
 {
     // array_expr has ARRAY_TYPE, desired_ptr_type is pointer to element type
@@ -131,6 +297,20 @@ struct enum_item_kv {
     HOST_WIDE_INT value;
 };
 
+/* enum_desc_val is int. Unsigned 32 bit values keep their bit pattern,
+   wider underlying types (enum class : int64_t) are truncated with a warning. */
+static HOST_WIDE_INT enum_item_value(tree enum_type, const char *name, tree val)
+{
+    if (tree_fits_shwi_p(val))
+    {
+        HOST_WIDE_INT v = tree_to_shwi(val);
+        if (v >= INT_MIN && v <= INT_MAX) return v;
+        if (v > INT_MAX && v <= (HOST_WIDE_INT)UINT_MAX) return (int)(unsigned)v;
+    }
+    warning(0, "enum %s: value of %s does not fit %<enum_desc_val%>", enum_names_for(enum_type).display.c_str(), name);
+    return (int)TREE_INT_CST_LOW(val);
+}
+
 static bool extract_enum_items(tree enum_type, std::vector<enum_item_kv> &out)
 {
     out.clear();
@@ -156,8 +336,7 @@ static bool extract_enum_items(tree enum_type, std::vector<enum_item_kv> &out)
             if (!val || TREE_CODE(val) != INTEGER_CST)
                 continue;
 
-            HOST_WIDE_INT v = TREE_INT_CST_LOW(val);
-            out.push_back({name, v});
+            out.push_back({name, enum_item_value(enum_type, name, val)});
             continue;
         }
 
@@ -172,8 +351,7 @@ static bool extract_enum_items(tree enum_type, std::vector<enum_item_kv> &out)
             if (!init || TREE_CODE(init) != INTEGER_CST)
                 continue;
 
-            HOST_WIDE_INT v = TREE_INT_CST_LOW(init);
-            out.push_back({name, v});
+            out.push_back({name, enum_item_value(enum_type, name, init)});
             continue;
         }
     }
@@ -181,8 +359,9 @@ static bool extract_enum_items(tree enum_type, std::vector<enum_item_kv> &out)
     return !out.empty();
 }
 
-/* Build lbl_str and lbl_off with 8 NUL padding */
+/* Build lbl_str and lbl_off with 8 NUL padding. Without labels, lbl_str has just the name. */
 static bool build_lbl_blob(const std::vector<enum_item_kv> &items,
+                           bool with_labels,
                            std::string &blob,
                            std::vector<uint16_t> &offs,
                            const char *ename_for_errors)
@@ -194,8 +373,9 @@ static bool build_lbl_blob(const std::vector<enum_item_kv> &items,
     blob.append(ename_for_errors);
     blob.push_back('\0');
 
-    for (auto &it : items)
+    for (size_t i = 0; with_labels && i < items.size(); i++)
     {
+        const enum_item_kv &it = items[i];
         offs.push_back((uint16_t)blob.size());
         blob.append(it.label);
         blob.push_back('\0');
@@ -210,82 +390,298 @@ static bool build_lbl_blob(const std::vector<enum_item_kv> &items,
     return true;
 }
 
-/* ------------------------------------------------------------ */
-/* Emit const arrays */
+/* Value range and membership bitmap, same rules as enum_refl_build */
+static bool build_value_bits(const std::vector<enum_item_kv> &items,
+                             HOST_WIDE_INT &vmin, HOST_WIDE_INT &vmax,
+                             std::vector<uint32_t> &bits)
+{
+    vmin = vmax = items[0].value;
+    for (auto &it : items)
+    {
+        if (it.value < vmin) vmin = it.value;
+        if (it.value > vmax) vmax = it.value;
+    }
 
-static tree emit_const_char_blob(const char *sym, const std::string &blob)
+    bits.clear();
+    unsigned HOST_WIDE_INT words = (unsigned HOST_WIDE_INT)(vmax - vmin) / 32 + 1;
+    if (words > ENUM_DESC_BITMAP_WORDS_MAX(items.size()))
+        return false;
+
+    bits.resize(words, 0);
+    for (auto &it : items)
+    {
+        unsigned HOST_WIDE_INT off = it.value - vmin;
+        bits[off >> 5] |= 1u << (off & 31);
+    }
+    return true;
+}
+
+static void build_value_rank(const std::vector<uint32_t> &bits,
+                             std::vector<HOST_WIDE_INT> &rank)
 {
-    tree cch = build_qualified_type(char_type_node, TYPE_QUAL_CONST);
-    tree arr_t = build_array_type_nelts(cch, (unsigned)blob.size());
+    rank.assign(bits.size(), 0);
+    for (size_t w = 1; w < bits.size(); w++)
+        rank[w] = rank[w-1] + __builtin_popcount(bits[w-1]);
+}
 
-    tree var = build_decl(BUILTINS_LOCATION, VAR_DECL, get_identifier(sym), arr_t);
-    TREE_STATIC(var) = 1;
-    TREE_READONLY(var) = 1;
-    DECL_ARTIFICIAL(var) = 1;
-    TREE_USED(var) = 1;
+/* First index of each distinct value sorted by value, and the alias chain.
+   Returns false when all values are distinct (no alias chain needed). */
+static bool build_value_index(const std::vector<enum_item_kv> &items,
+                              std::vector<HOST_WIDE_INT> &by_value,
+                              std::vector<HOST_WIDE_INT> &alias_next)
+{
+    std::vector<int> order(items.size());
+    for (size_t i = 0; i < items.size(); i++) order[i] = (int)i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return items[a].value < items[b].value; });
+
+    by_value.clear();
+    alias_next.assign(items.size(), -1);
+    bool has_alias = false;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        if (i > 0 && items[order[i]].value == items[order[i-1]].value)
+        {
+            alias_next[order[i-1]] = order[i];
+            has_alias = true;
+            continue;
+        }
+        by_value.push_back(order[i]);
+    }
+    return has_alias;
+}
 
-    vec<constructor_elt, va_gc> *elts = NULL;
-    for (unsigned i = 0; i < (unsigned)blob.size(); i++)
+/* Every index sorted by label (byte order, as strcmp), equal labels in declaration order */
+static void build_label_order(const std::vector<enum_item_kv> &items,
+                              std::vector<HOST_WIDE_INT> &by_label)
+{
+    std::vector<int> order(items.size());
+    for (size_t i = 0; i < items.size(); i++) order[i] = (int)i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return strcmp(items[a].label.c_str(), items[b].label.c_str()) < 0; });
+    by_label.assign(order.begin(), order.end());
+}
+
+/* Content fingerprint, must match enum_desc_fingerprint_of (src/enum_desc_diff.c):
+   FNV-1a 64 over name and NUL, then per item label and NUL and the value as
+   4 bytes little endian. 0 means "not stored", so it maps to 1. */
+static uint64_t content_fingerprint(const char *ename,
+                                    const std::vector<enum_item_kv> &items)
+{
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](const void *p, size_t n) {
+        const unsigned char *s = (const unsigned char *)p;
+        for (size_t i = 0; i < n; i++) h = (h ^ s[i]) * 1099511628211ULL;
+    };
+    mix(ename, strlen(ename) + 1);
+    for (auto &it : items)
     {
-        tree idx = build_int_cst(integer_type_node, (int)i);
-        unsigned char b = (unsigned char)blob[i];
-        tree bv = build_int_cst(char_type_node, (int)b);
-        CONSTRUCTOR_APPEND_ELT(elts, idx, bv);
+        uint32_t v = (uint32_t)it.value;
+        const unsigned char le[4] = { (unsigned char)v, (unsigned char)(v >> 8),
+                                      (unsigned char)(v >> 16), (unsigned char)(v >> 24) };
+        mix(it.label.c_str(), it.label.size() + 1);
+        mix(le, sizeof(le));
     }
+    return h ? h : 1;
+}
 
-    DECL_INITIAL(var) = build_constructor(arr_t, elts);
-    varpool_node::finalize_decl(var);
-    return var;
+/* Offset -> index table for enum_desc_index_of_label_ptr */
+static void build_lbl_blk(const std::vector<uint16_t> &offs,
+                          std::vector<HOST_WIDE_INT> &blk)
+{
+    blk.clear();
+    if (offs.empty()) return;
+    size_t blk_count = (offs.back() >> 3) + 1;
+    size_t i = 0;
+    for (size_t b = 0; b < blk_count; b++)
+    {
+        while (offs[i] < b*8) i++;
+        blk.push_back((HOST_WIDE_INT)i);
+    }
 }
 
-static tree emit_const_u16_array(const char *sym, const std::vector<uint16_t> &a)
+/* Label radix trie, same layout as enum_desc_trie_build (enum_desc_trie.c).
+   With offs, edges point into lbl_str. Without, edge bytes go to trie.segs. */
+struct lbl_trie {
+    std::vector<HOST_WIDE_INT> seg_off, seg_len, parent, child, term, leaf;
+    std::string segs;
+};
+
+static bool build_lbl_trie(const std::vector<enum_item_kv> &items,
+                           const std::vector<uint16_t> &offs,
+                           lbl_trie &trie)
 {
-    tree u16 = make_u16_type();
-    tree elem_t = build_qualified_type(u16, TYPE_QUAL_CONST);
-    tree arr_t = build_array_type_nelts(elem_t, (unsigned)a.size());
+    size_t n = items.size();
+    if (2*n + 1 > 65535)
+        return false;
 
-    tree var = build_decl(BUILTINS_LOCATION, VAR_DECL, get_identifier(sym), arr_t);
-    TREE_STATIC(var) = 1;
-    TREE_READONLY(var) = 1;
-    DECL_ARTIFICIAL(var) = 1;
-    TREE_USED(var) = 1;
+    std::vector<int> sorted(n);
+    for (size_t i = 0; i < n; i++) sorted[i] = (int)i;
+    std::stable_sort(sorted.begin(), sorted.end(), [&](int a, int b) {
+        return strcmp(items[a].label.c_str(), items[b].label.c_str()) < 0;
+    });
+
+    struct span { size_t lo, hi, depth; };
+    std::vector<span> spans;
+    trie = lbl_trie();
+    trie.leaf.assign(n, 0);
+    spans.push_back({0, n, 0});
+    trie.seg_off.push_back(0);
+    trie.seg_len.push_back(0);
+    trie.parent.push_back(0);
+    for (size_t i = 0; i < spans.size(); i++)
+    {
+        size_t lo = spans[i].lo, hi = spans[i].hi, depth = spans[i].depth;
+        trie.child.push_back((HOST_WIDE_INT)spans.size());
+        trie.term.push_back(-1);
+        // Labels ending here sort first in the run, lowest index first
+        for (; lo < hi && items[sorted[lo]].label.size() == depth; lo++)
+        {
+            if (trie.term[i] < 0) trie.term[i] = sorted[lo];
+            trie.leaf[sorted[lo]] = (HOST_WIDE_INT)i;
+        }
+        for (size_t a = lo, b; a < hi; a = b)
+        {
+            const std::string &first = items[sorted[a]].label;
+            for (b = a + 1; b < hi && items[sorted[b]].label[depth] == first[depth]; b++)
+                ;
+            const std::string &last = items[sorted[b-1]].label;
+            size_t k = depth;
+            while (k < first.size() && k < last.size() && first[k] == last[k]) k++;
+            if (!offs.empty())
+                trie.seg_off.push_back(offs[sorted[a]] + depth);
+            else
+            {
+                trie.seg_off.push_back((HOST_WIDE_INT)trie.segs.size());
+                trie.segs.append(first, depth, k - depth);
+            }
+            trie.seg_len.push_back((HOST_WIDE_INT)(k - depth));
+            trie.parent.push_back((HOST_WIDE_INT)i);
+            spans.push_back({a, b, k});
+        }
+    }
+    trie.child.push_back((HOST_WIDE_INT)spans.size());
+    return true;
+}
+
+/* ------------------------------------------------------------ */
+/* Emit const arrays */
+
+/* CONSTRUCTOR for a const array of elem */
+static tree build_array_init(tree elem, const std::vector<HOST_WIDE_INT> &a)
+{
+    tree elem_t = build_qualified_type(elem, TYPE_QUAL_CONST);
+    tree arr_t = build_array_type_nelts(elem_t, (unsigned)a.size());
 
     vec<constructor_elt, va_gc> *elts = NULL;
     for (unsigned i = 0; i < a.size(); i++)
     {
         tree idx = build_int_cst(integer_type_node, (int)i);
-        tree vv  = build_int_cst(u16, (int)a[i]);
+        tree vv  = build_int_cst(elem, a[i]);
         CONSTRUCTOR_APPEND_ELT(elts, idx, vv);
     }
+    return build_constructor(arr_t, elts);
+}
 
-    DECL_INITIAL(var) = build_constructor(arr_t, elts);
-    varpool_node::finalize_decl(var);
-    return var;
+static tree build_blob_init(const std::string &blob)
+{
+    std::vector<HOST_WIDE_INT> a;
+    for (unsigned char b : blob) a.push_back(b);
+    return build_array_init(char_type_node, a);
 }
 
-static tree emit_const_int_array(const char *sym, const std::vector<enum_item_kv> &items)
+static tree build_u16_init(const std::vector<uint16_t> &v)
 {
-    tree elem_t = build_qualified_type(integer_type_node, TYPE_QUAL_CONST);
-    tree arr_t  = build_array_type_nelts(elem_t, (unsigned)items.size());
+    return build_array_init(make_u16_type(), std::vector<HOST_WIDE_INT>(v.begin(), v.end()));
+}
 
-    tree var = build_decl(BUILTINS_LOCATION, VAR_DECL, get_identifier(sym), arr_t);
+static tree build_u32_init(const std::vector<uint32_t> &v)
+{
+    return build_array_init(make_u32_type(), std::vector<HOST_WIDE_INT>(v.begin(), v.end()));
+}
+
+static tree build_int_init(const std::vector<enum_item_kv> &items)
+{
+    std::vector<HOST_WIDE_INT> a;
+    for (auto &it : items) a.push_back(it.value);
+    return build_array_init(integer_type_node, a);
+}
+
+/* Array of the pointee type of a struct enum_desc field */
+static tree build_field_init(tree field, const std::vector<HOST_WIDE_INT> &a)
+{
+    return build_array_init(TYPE_MAIN_VARIANT(TREE_TYPE(TREE_TYPE(field))), a);
+}
+
+static tree emit_const_var(const char *sym, tree init)
+{
+    tree var = build_decl(BUILTINS_LOCATION, VAR_DECL, get_identifier(sym), TREE_TYPE(init));
     TREE_STATIC(var) = 1;
     TREE_READONLY(var) = 1;
     DECL_ARTIFICIAL(var) = 1;
     TREE_USED(var) = 1;
+    DECL_INITIAL(var) = init;
+    varpool_node::finalize_decl(var);
+    return var;
+}
 
-    vec<constructor_elt, va_gc> *elts = NULL;
-    for (unsigned i = 0; i < items.size(); i++)
+/* Co-located descriptor: one cache line aligned object holding the header
+   followed by the arrays a lookup reads.  Parts are added first, the header
+   initializer is set once the object exists, since it points into the object
+   itself. */
+#define ENUM_DESC_PACK_ALIGN 64
+
+struct desc_pack {
+    std::vector<tree> fields;
+    std::vector<tree> inits;
+    tree var = NULL_TREE;
+
+    int add(const char *name, tree type, tree init)
     {
-        tree idx = build_int_cst(integer_type_node, (int)i);
-        tree vv  = build_int_cst(integer_type_node, items[i].value);
-        CONSTRUCTOR_APPEND_ELT(elts, idx, vv);
+        tree fld = build_decl(BUILTINS_LOCATION, FIELD_DECL, get_identifier(name), type);
+        fields.push_back(fld);
+        inits.push_back(init);
+        return (int)fields.size() - 1;
     }
+    int add(const char *name, tree init) { return add(name, TREE_TYPE(init), init); }
 
-    DECL_INITIAL(var) = build_constructor(arr_t, elts);
-    varpool_node::finalize_decl(var);
-    return var;
-}
+    /* Lay out the record, declare the object */
+    tree declare(const char *sym)
+    {
+        tree chain = NULL_TREE;     // finish_builtin_struct takes the fields reversed
+        for (tree fld : fields)
+        {
+            DECL_CHAIN(fld) = chain;
+            chain = fld;
+        }
+        tree rec = make_node(RECORD_TYPE);
+        finish_builtin_struct(rec, "__enum_desc_pack", chain, NULL_TREE);
+
+        var = build_decl(BUILTINS_LOCATION, VAR_DECL, get_identifier(sym), rec);
+        TREE_STATIC(var) = 1;
+        TREE_READONLY(var) = 1;
+        DECL_ARTIFICIAL(var) = 1;
+        TREE_USED(var) = 1;
+        TREE_ADDRESSABLE(var) = 1;
+        SET_DECL_ALIGN(var, ENUM_DESC_PACK_ALIGN * BITS_PER_UNIT);
+        DECL_USER_ALIGN(var) = 1;
+        return var;
+    }
+
+    tree ref(int part) const
+    {
+        return build3(COMPONENT_REF, TREE_TYPE(fields[part]), var, fields[part], NULL_TREE);
+    }
+
+    void emit()
+    {
+        vec<constructor_elt, va_gc> *elts = NULL;
+        for (size_t i = 0; i < fields.size(); i++)
+            CONSTRUCTOR_APPEND_ELT(elts, fields[i], inits[i]);
+        DECL_INITIAL(var) = build_constructor(TREE_TYPE(var), elts);
+        varpool_node::finalize_decl(var);
+    }
+};
 
 /* ------------------------------------------------------------ */
 /* Emit enum_desc (real type) */
@@ -313,7 +709,22 @@ static void lookup_fields(tree record_type)
         .f_strs = field_by_name(record_type, "strs"),
         .f_value_count = field_by_name(record_type, "value_count"),
         .f_lbl_off = field_by_name(record_type, "lbl_off"),
-        .f_values = field_by_name(record_type, "values")
+        .f_values = field_by_name(record_type, "values"),
+        .f_flags = field_by_name(record_type, "flags"),
+        .f_value_min = field_by_name(record_type, "value_min"),
+        .f_value_max = field_by_name(record_type, "value_max"),
+        .f_value_bits = field_by_name(record_type, "value_bits"),
+        .f_value_rank = field_by_name(record_type, "value_rank"),
+        .f_uniq_count = field_by_name(record_type, "uniq_count"),
+        .f_by_value = field_by_name(record_type, "by_value"),
+        .f_alias_next = field_by_name(record_type, "alias_next"),
+        .f_lbl_blk = field_by_name(record_type, "lbl_blk"),
+        .f_trie = field_by_name(record_type, "trie"),
+        .f_lbl_cache = field_by_name(record_type, "lbl_cache"),
+        .f_label_set_count = field_by_name(record_type, "label_set_count"),
+        .f_label_sets = field_by_name(record_type, "label_sets"),
+        .f_by_label = field_by_name(record_type, "by_label"),
+        .f_fingerprint = field_by_name(record_type, "fingerprint"),
     };
 
     if (!g_enum_desc_fields.f_strs ||
@@ -327,6 +738,173 @@ static void lookup_fields(tree record_type)
     field_lookup_done = true;
 }
 
+/* const struct enum_desc_trie and its arrays. segs_var is lbl_str, or the trie's own edge blob. */
+static tree emit_trie(const std::string &esym, const lbl_trie &trie, tree segs_var)
+{
+    tree rec = TYPE_MAIN_VARIANT(TREE_TYPE(TREE_TYPE(g_enum_desc_fields.f_trie)));
+    if (TREE_CODE(rec) != RECORD_TYPE || !COMPLETE_TYPE_P(rec))
+        return NULL_TREE;
+
+    struct { const char *name; const std::vector<HOST_WIDE_INT> *a; } arrays[] = {
+        { "seg_off", &trie.seg_off }, { "seg_len", &trie.seg_len }, { "parent", &trie.parent },
+        { "child", &trie.child }, { "term", &trie.term }, { "leaf", &trie.leaf },
+    };
+    tree f_count = field_by_name(rec, "node_count");
+    tree f_segs = field_by_name(rec, "segs");
+    if (!f_count || !f_segs)
+        return NULL_TREE;
+    for (auto &arr : arrays)
+        if (!field_by_name(rec, arr.name))
+            return NULL_TREE;
+
+    hash_map<tree, tree> fv;
+    fv.put(f_count, build_int_cst(TREE_TYPE(f_count), (HOST_WIDE_INT)trie.term.size()));
+    fv.put(f_segs, ptr_to_first_elem(segs_var, TREE_TYPE(f_segs)));
+    for (auto &arr : arrays)
+    {
+        tree fld = field_by_name(rec, arr.name);
+        std::string sym = std::string("__enum_trie") + arr.name + "_" + esym;
+        tree var = emit_const_var(sym.c_str(), build_field_init(fld, *arr.a));
+        fv.put(fld, ptr_to_first_elem(var, TREE_TYPE(fld)));
+    }
+
+    vec<constructor_elt, va_gc> *elts = NULL;
+    for (tree fld = TYPE_FIELDS(rec); fld; fld = DECL_CHAIN(fld))
+    {
+        tree *v = fv.get(fld);
+        if (v) CONSTRUCTOR_APPEND_ELT(elts, fld, *v);
+    }
+
+    std::string sym = "__enum_trie_" + esym;
+    tree var = build_decl(BUILTINS_LOCATION, VAR_DECL, get_identifier(sym.c_str()), rec);
+    TREE_STATIC(var) = 1;
+    TREE_READONLY(var) = 1;
+    DECL_ARTIFICIAL(var) = 1;
+    TREE_USED(var) = 1;
+    DECL_INITIAL(var) = build_constructor(rec, elts);
+    varpool_node::finalize_decl(var);
+    return var;
+}
+
+/* Writable, zero initialized pointer for labels materialized at run time */
+static tree emit_lbl_cache(const std::string &esym)
+{
+    tree slot_t = TREE_TYPE(TREE_TYPE(g_enum_desc_fields.f_lbl_cache));
+    std::string sym = "__enum_lblcache_" + esym;
+    tree var = build_decl(BUILTINS_LOCATION, VAR_DECL, get_identifier(sym.c_str()), slot_t);
+    TREE_STATIC(var) = 1;
+    DECL_ARTIFICIAL(var) = 1;
+    TREE_USED(var) = 1;
+    TREE_ADDRESSABLE(var) = 1;
+    DECL_INITIAL(var) = fold_convert(slot_t, null_pointer_node);
+    varpool_node::finalize_decl(var);
+    return var;
+}
+
+/* Labels of one set. A label the transforms would leave empty stays as declared. */
+static std::vector<enum_item_kv> transform_labels(const std::vector<enum_item_kv> &items,
+                                                  const label_set_spec &spec)
+{
+    std::vector<enum_item_kv> out = items;
+    for (int t : spec.transforms)
+    {
+        if (t == LSET_STRIP_PREFIX)
+        {
+            if (out.size() < 2) continue;
+            size_t common = out[0].label.size();
+            for (auto &it : out)
+            {
+                size_t k = 0;
+                while (k < common && k < it.label.size() && it.label[k] == out[0].label[k]) k++;
+                common = k;
+            }
+            size_t cut = out[0].label.rfind('_', common ? common - 1 : 0);
+            if (cut == std::string::npos || cut >= common) continue;
+            for (auto &it : out)
+                if (it.label.size() > cut + 1)
+                    it.label.erase(0, cut + 1);
+        }
+        else
+        {
+            for (auto &it : out)
+                for (char &c : it.label)
+                    c = t == LSET_LOWER ? TOLOWER(c) : TOUPPER(c);
+        }
+    }
+    return out;
+}
+
+/* const struct enum_desc_label_set[] for the label-set= args, NULL_TREE if the header has no such type */
+static tree emit_label_sets(const std::string &esym, const std::vector<enum_item_kv> &items)
+{
+    tree rec = TYPE_MAIN_VARIANT(TREE_TYPE(TREE_TYPE(g_enum_desc_fields.f_label_sets)));
+    if (TREE_CODE(rec) != RECORD_TYPE || !COMPLETE_TYPE_P(rec))
+        return NULL_TREE;
+    tree f_strs = field_by_name(rec, "strs");
+    tree f_off = field_by_name(rec, "lbl_off");
+    tree f_trie = field_by_name(rec, "trie");
+    if (!f_strs || !f_off)
+        return NULL_TREE;
+
+    vec<constructor_elt, va_gc> *sets = NULL;
+    for (size_t k = 0; k < g_label_sets.size(); k++)
+    {
+        const label_set_spec &spec = g_label_sets[k];
+        std::vector<enum_item_kv> set_items = transform_labels(items, spec);
+        std::string blob;
+        std::vector<uint16_t> offs;
+        if (!build_lbl_blob(set_items, true, blob, offs, spec.name.c_str()))
+            return NULL_TREE;
+
+        std::string n = std::to_string(k + 1);
+        tree str_var = emit_const_var(("__enum_lsetstr" + n + "_" + esym).c_str(), build_blob_init(blob));
+        tree off_var = emit_const_var(("__enum_lsetoff" + n + "_" + esym).c_str(), build_u16_init(offs));
+
+        hash_map<tree, tree> fv;
+        fv.put(f_strs, ptr_to_first_elem(str_var, TREE_TYPE(f_strs)));
+        fv.put(f_off, ptr_to_first_elem(off_var, TREE_TYPE(f_off)));
+        lbl_trie trie;
+        if (f_trie && g_enum_desc_fields.f_trie && items.size() >= g_trie_min_count && build_lbl_trie(set_items, offs, trie))
+        {
+            tree trie_var = emit_trie(esym + "_set" + n, trie, str_var);
+            if (trie_var)
+            {
+                TREE_ADDRESSABLE(trie_var) = 1;
+                fv.put(f_trie, fold_convert(TREE_TYPE(f_trie), build_fold_addr_expr(trie_var)));
+            }
+        }
+
+        vec<constructor_elt, va_gc> *elts = NULL;
+        for (tree fld = TYPE_FIELDS(rec); fld; fld = DECL_CHAIN(fld))
+        {
+            tree *v = fv.get(fld);
+            if (v) CONSTRUCTOR_APPEND_ELT(elts, fld, *v);
+        }
+        CONSTRUCTOR_APPEND_ELT(sets, build_int_cst(integer_type_node, (int)k), build_constructor(rec, elts));
+    }
+
+    tree arr_t = build_array_type_nelts(build_qualified_type(rec, TYPE_QUAL_CONST), (unsigned)g_label_sets.size());
+    return emit_const_var(("__enum_lsets_" + esym).c_str(), build_constructor(arr_t, sets));
+}
+
+/* Pointer to the descriptor in section enum_desc_reg, see enum_desc_registry() */
+static void emit_registry_entry(const char *esym, tree desc_var)
+{
+    std::string sym = std::string("__enum_reg_") + esym;
+
+    tree ptr_t = build_pointer_type(build_qualified_type(g_enum_desc_record, TYPE_QUAL_CONST));
+    tree var = build_decl(BUILTINS_LOCATION, VAR_DECL, get_identifier(sym.c_str()), ptr_t);
+    TREE_STATIC(var) = 1;
+    DECL_ARTIFICIAL(var) = 1;
+    TREE_USED(var) = 1;
+    DECL_PRESERVE_P(var) = 1;       // nothing references it, keep it anyway
+    set_decl_section_name(var, "enum_desc_reg");
+
+    TREE_ADDRESSABLE(desc_var) = 1;
+    DECL_INITIAL(var) = fold_convert(ptr_t, build_fold_addr_expr(desc_var));
+    varpool_node::finalize_decl(var);
+}
+
 static void emit_enum_desc_for(tree enum_type)
 {
     if (!g_enum_desc_record)
@@ -336,9 +914,19 @@ static void emit_enum_desc_for(tree enum_type)
     }
     lookup_fields(g_enum_desc_record);
 
-    const char *ename = type_name_cstr(enum_type);
+    const enum_names &names = enum_names_for(enum_type);
+    const char *ename = names.display.c_str();
+    const char *esym = names.sym.c_str();
+    bool is_public = g_public_enums.contains(enum_type);
     dprintf("%s: emitting enum_desc for %s\n", __func__, ename);
 
+    if (is_public && names.suffixed)
+    {
+        error("enum %qs: public descriptor name %<__enum_desc__%s%> clashes with another enum",
+              ename, esym);
+        return;
+    }
+
     std::vector<enum_item_kv> items;
     if (!extract_enum_items(enum_type, items))
     {
@@ -346,37 +934,131 @@ static void emit_enum_desc_for(tree enum_type)
         return;
     }
 
+    struct enum_desc_fields &f = g_enum_desc_fields ;
+
+    size_t lbl_bytes = 0;
+    for (auto &it : items) lbl_bytes += it.label.size() + 1;
+    bool use_trie = f.f_trie && items.size() >= g_trie_min_count;
+    bool trie_only = use_trie && f.f_lbl_cache && f.f_flags && lbl_bytes >= g_trie_labels_min_bytes;
+
     std::string blob;
     std::vector<uint16_t> offs;
-    if (!build_lbl_blob(items, blob, offs, ename))
+    if (!build_lbl_blob(items, !trie_only, blob, offs, ename))
         return;
 
-    char sym_lbl[256], sym_off[256], sym_val[256], sym_desc[256];
-    snprintf(sym_lbl,  sizeof(sym_lbl),  "__enum_lblstr_%s", ename);
-    snprintf(sym_off,  sizeof(sym_off),  "__enum_lbloff_%s", ename);
-    snprintf(sym_val,  sizeof(sym_val),  "__enum_vals_%s",   ename);
-    snprintf(sym_desc, sizeof(sym_desc), "__enum_desc__%s",   ename);
-
-    tree lbl_var = emit_const_char_blob(sym_lbl, blob);
-    tree off_var = emit_const_u16_array(sym_off, offs);
-    tree val_var = emit_const_int_array(sym_val, items);
+    lbl_trie trie;
+    if (use_trie && !build_lbl_trie(items, offs, trie))
+    {
+        if (trie_only)
+        {
+            error("enum %s: too many items for the label trie", ename);
+            return;
+        }
+        use_trie = false;
+    }
 
-    // Create desc var with the *real* type
-    tree desc_var = build_decl(BUILTINS_LOCATION, VAR_DECL,
-                               get_identifier(sym_desc), g_enum_desc_record);
-    TREE_STATIC(desc_var) = 1;
-    TREE_READONLY(desc_var) = 1;
-    DECL_ARTIFICIAL(desc_var) = 1;
-    TREE_USED(desc_var) = 1;
+    HOST_WIDE_INT vmin, vmax;
+    std::vector<uint32_t> bits;
+    bool has_bits = build_value_bits(items, vmin, vmax, bits);
+
+    std::vector<HOST_WIDE_INT> rank, by_value, alias_next;
+    if (has_bits)
+        build_value_rank(bits, rank);
+    bool has_alias = build_value_index(items, by_value, alias_next);
+    std::vector<HOST_WIDE_INT> lbl_blk, by_label;
+    build_lbl_blk(offs, lbl_blk);
+    build_label_order(items, by_label);
+
+    // Symbols can get long for C++ names, keep them whole so the unique suffix survives
+    auto sym_for = [&](const char *prefix) { return std::string(prefix) + names.sym; };
+    std::string sym_pack = sym_for("__enum_pack_");
+    std::string sym_alias = sym_for("__enum_alias_");
+    std::string sym_blk = sym_for("__enum_lblblk_");
+    std::string sym_seg = sym_for("__enum_trieseg_");
+    std::string sym_bylabel = sym_for("__enum_bylabel_");
+    std::string sym_desc = sym_for("__enum_desc__");
+
+    // Header -> values -> offsets -> labels -> value index, in one object
+    desc_pack pack;
+    int p_hdr = pack.add("hdr", g_enum_desc_record, NULL_TREE);
+    int p_val = pack.add("vals", build_int_init(items));
+    int p_off = trie_only ? -1 : pack.add("lbloff", build_u16_init(offs));
+    int p_lbl = pack.add("lblstr", build_blob_init(blob));
+    int p_bits = has_bits && f.f_value_bits ? pack.add("valbits", build_u32_init(bits)) : -1;
+    int p_rank = p_bits >= 0 && f.f_value_rank ? pack.add("valrank", build_field_init(f.f_value_rank, rank)) : -1;
+    int p_byval = f.f_by_value && f.f_uniq_count ? pack.add("byval", build_field_init(f.f_by_value, by_value)) : -1;
+    tree pack_var = pack.declare(sym_pack.c_str());
+    // Public descriptors are emitted by every unit that sees the enum: one comdat
+    // group per enum, the linker keeps one copy.
+    if (is_public)
+        make_decl_one_only(pack_var, DECL_ASSEMBLER_NAME(pack_var));
+
+    tree lbl_ref = pack.ref(p_lbl);
+    tree alias_var = p_byval >= 0 && has_alias && f.f_alias_next ? emit_const_var(sym_alias.c_str(), build_field_init(f.f_alias_next, alias_next)) : NULL_TREE;
+    tree blk_var = f.f_lbl_blk && !trie_only ? emit_const_var(sym_blk.c_str(), build_field_init(f.f_lbl_blk, lbl_blk)) : NULL_TREE;
+    // Sorted iteration only, kept out of the pack
+    tree bylabel_var = f.f_by_label ? emit_const_var(sym_bylabel.c_str(), build_field_init(f.f_by_label, by_label)) : NULL_TREE;
+    tree trie_var = NULL_TREE, cache_var = NULL_TREE;
+    if (use_trie)
+    {
+        tree segs_var = trie_only ? emit_const_var(sym_seg.c_str(), build_blob_init(trie.segs)) : lbl_ref;
+        trie_var = emit_trie(names.sym, trie, segs_var);
+        if (trie_only && !trie_var)
+        {
+            error("enum %s: %<struct enum_desc_trie%> does not match the plugin", ename);
+            return;
+        }
+        if (trie_only)
+            cache_var = emit_lbl_cache(names.sym);
+    }
+    tree lsets_var = !g_label_sets.empty() && f.f_label_sets && f.f_label_set_count ? emit_label_sets(names.sym, items) : NULL_TREE;
 
     vec<constructor_elt, va_gc> *elts = NULL;
     hash_map<tree, tree> fv ;
-//    struct enum_desc_fields &f = g_enum_desc_fields ;
-    struct enum_desc_fields &f = g_enum_desc_fields ;
     fv.put(f.f_value_count, fold_convert(TREE_TYPE(f.f_value_count), build_int_cst(integer_type_node, (int)items.size())));
-    fv.put(f.f_values, ptr_to_first_elem(val_var, TREE_TYPE(f.f_values)));
-    fv.put(f.f_lbl_off, ptr_to_first_elem(off_var, TREE_TYPE(f.f_lbl_off)));
-    fv.put(f.f_strs, ptr_to_first_elem(lbl_var, TREE_TYPE(f.f_strs)));
+    fv.put(f.f_values, ptr_to_first_elem(pack.ref(p_val), TREE_TYPE(f.f_values)));
+    if (p_off >= 0)
+        fv.put(f.f_lbl_off, ptr_to_first_elem(pack.ref(p_off), TREE_TYPE(f.f_lbl_off)));
+    fv.put(f.f_strs, ptr_to_first_elem(lbl_ref, TREE_TYPE(f.f_strs)));
+    if (f.f_flags)
+    {
+        int flags = (f.f_value_min && f.f_value_max ? ENUM_DESC_F_RANGE : 0) | (trie_only ? ENUM_DESC_F_TRIE_LABELS : 0);
+        fv.put(f.f_flags, build_int_cst(TREE_TYPE(f.f_flags), flags));
+    }
+    if (f.f_flags && f.f_value_min && f.f_value_max)
+    {
+        fv.put(f.f_value_min, build_int_cst(TREE_TYPE(f.f_value_min), vmin));
+        fv.put(f.f_value_max, build_int_cst(TREE_TYPE(f.f_value_max), vmax));
+    }
+    if (p_bits >= 0)
+        fv.put(f.f_value_bits, ptr_to_first_elem(pack.ref(p_bits), TREE_TYPE(f.f_value_bits)));
+    if (p_rank >= 0)
+        fv.put(f.f_value_rank, ptr_to_first_elem(pack.ref(p_rank), TREE_TYPE(f.f_value_rank)));
+    if (p_byval >= 0)
+    {
+        fv.put(f.f_uniq_count, build_int_cst(TREE_TYPE(f.f_uniq_count), (HOST_WIDE_INT)by_value.size()));
+        fv.put(f.f_by_value, ptr_to_first_elem(pack.ref(p_byval), TREE_TYPE(f.f_by_value)));
+    }
+    if (alias_var)
+        fv.put(f.f_alias_next, ptr_to_first_elem(alias_var, TREE_TYPE(f.f_alias_next)));
+    if (blk_var)
+        fv.put(f.f_lbl_blk, ptr_to_first_elem(blk_var, TREE_TYPE(f.f_lbl_blk)));
+    if (bylabel_var)
+        fv.put(f.f_by_label, ptr_to_first_elem(bylabel_var, TREE_TYPE(f.f_by_label)));
+    if (trie_var)
+    {
+        TREE_ADDRESSABLE(trie_var) = 1;
+        fv.put(f.f_trie, fold_convert(TREE_TYPE(f.f_trie), build_fold_addr_expr(trie_var)));
+    }
+    if (cache_var)
+        fv.put(f.f_lbl_cache, fold_convert(TREE_TYPE(f.f_lbl_cache), build_fold_addr_expr(cache_var)));
+    if (f.f_fingerprint)
+        fv.put(f.f_fingerprint, build_int_cstu(TREE_TYPE(f.f_fingerprint), content_fingerprint(ename, items)));
+    if (lsets_var)
+    {
+        fv.put(f.f_label_set_count, build_int_cst(TREE_TYPE(f.f_label_set_count), (HOST_WIDE_INT)g_label_sets.size()));
+        fv.put(f.f_label_sets, ptr_to_first_elem(lsets_var, TREE_TYPE(f.f_label_sets)));
+    }
     for (tree f = TYPE_FIELDS(g_enum_desc_record); f; f = DECL_CHAIN(f))
     {
         tree *s = fv.get(f);
@@ -384,8 +1066,29 @@ static void emit_enum_desc_for(tree enum_type)
     }
 
     // Anything not explicitly mentioned is zero-initialized by the constructor.
-    DECL_INITIAL(desc_var) = build_constructor(g_enum_desc_record, elts);
-    varpool_node::finalize_decl(desc_var);
+    pack.inits[p_hdr] = build_constructor(g_enum_desc_record, elts);
+    pack.emit();
+
+    // The header is at offset 0: __enum_desc__<E> (the var a rewritten wrapper may
+    // already point to) becomes an alias of the pack, keeping the real type.
+    auto dv = g_enumtype_to_descvar.find(enum_type);
+    tree desc_var = dv != g_enumtype_to_descvar.end() ? dv->second
+                  : build_decl(BUILTINS_LOCATION, VAR_DECL, get_identifier(sym_desc.c_str()), g_enum_desc_record);
+    DECL_EXTERNAL(desc_var) = 0;
+    TREE_STATIC(desc_var) = 1;
+    TREE_PUBLIC(desc_var) = is_public;
+    TREE_READONLY(desc_var) = 1;
+    DECL_ARTIFICIAL(desc_var) = 1;
+    TREE_USED(desc_var) = 1;
+    DECL_INITIAL(desc_var) = NULL_TREE;
+    DECL_ATTRIBUTES(desc_var) = tree_cons(get_identifier("alias"),
+                                          build_tree_list(NULL_TREE, build_string(sym_pack.size(), sym_pack.c_str())),
+                                          DECL_ATTRIBUTES(desc_var));
+    varpool_node *alias_node = varpool_node::create_alias(desc_var, pack_var);
+    if (is_public)
+        alias_node->add_to_same_comdat_group(varpool_node::get(pack_var));
+
+    emit_registry_entry(esym, desc_var);
 }
 
 /* ------------------------------------------------------------ */
@@ -393,9 +1096,7 @@ static void emit_enum_desc_for(tree enum_type)
 
 static void process_enum_reflect_call(gimple *stmt)
 {
-    tree fndecl = gimple_call_fndecl(stmt);
-    const char *fname = fndecl_name_cstr(fndecl);
-    if (!fname || streq(fname, kReflectFnName))
+    if (!is_reflect_fn(gimple_call_fndecl(stmt)))
         return;
 
     dprintf("%s: found call to %s\n", __func__, kReflectFnName);
@@ -419,17 +1120,18 @@ static void process_enum_reflect_call(gimple *stmt)
     }
 
     // Remember for later emission
-    g_seen_enums.add(type);
+    note_enum(type);
 }
 
 /* ------------------------------------------------------------ */
-/* GIMPLE pass */
+/* GIMPLE pass: runs after the call graph edges are built and only looks at the
+   direct calls of each function, so the cost follows the calls, not the statements. */
 
 static const pass_data enum_refl_pass_data = {
     GIMPLE_PASS,
     "enum_refl",
     OPTGROUP_NONE,
-    TV_NONE,
+    TV_PLUGIN_RUN,
     0, 0, 0,
     0, 0
 };
@@ -442,19 +1144,24 @@ public:
         : gimple_opt_pass(enum_refl_pass_data, ctx)
     {}
 
-    unsigned int execute(function *) override
+    bool gate(function *) override
+    {
+        return g_reflect_declared;
+    }
+
+    unsigned int execute(function *fun) override
     {
-        basic_block bb;
-        FOR_EACH_BB_FN(bb, cfun)
+        cgraph_node *node = cgraph_node::get(fun->decl);
+        if (!node)
+            return 0;
+        g_stats.functions++;
+        for (cgraph_edge *e = node->callees; e; e = e->next_callee)
         {
-            for (gimple_stmt_iterator gsi = gsi_start_bb(bb);
-                 !gsi_end_p(gsi);
-                 gsi_next(&gsi))
-            {
-                gimple *stmt = gsi_stmt(gsi);
-                if (is_gimple_call(stmt))
-                    process_enum_reflect_call(stmt);
-            }
+            g_stats.call_edges++;
+            if (!e->call_stmt || !is_reflect_fn(e->callee->decl))
+                continue;
+            g_stats.sites++;
+            process_enum_reflect_call(e->call_stmt);
         }
         return 0;
     }
@@ -479,15 +1186,45 @@ static const char *record_tag_name(tree rec)
     return IDENTIFIER_POINTER(tn);
 }
 
-static void on_finish_type(void *event_data, void *)
+/* __attribute__((enum_reflect)) on an enum: the type stays as it is, the enum is
+   noted here or in on_finish_type, whichever sees it complete. */
+static tree handle_enum_reflect_attribute(tree *node, tree name, tree, int, bool *no_add_attrs)
 {
-    if ( g_enum_desc_record ) return; // already found
+    if (TREE_CODE(*node) != ENUMERAL_TYPE)
+    {
+        warning(OPT_Wattributes, "%qE attribute only applies to enums", name);
+        *no_add_attrs = true;
+        return NULL_TREE;
+    }
+    if (COMPLETE_TYPE_P(*node))
+        note_public_enum(*node);
+    return NULL_TREE;
+}
 
+static struct attribute_spec enum_reflect_attr = {
+    "enum_reflect", 0, 0, false, true, false, false, handle_enum_reflect_attribute, NULL
+};
+
+static void on_register_attributes(void *, void *)
+{
+    register_attribute(&enum_reflect_attr);
+}
+
+static void on_finish_type(void *event_data, void *)
+{
     tree t = (tree)event_data;
     if (!t) return;
 
     t = TYPE_MAIN_VARIANT(t);
 
+    if (TREE_CODE(t) == ENUMERAL_TYPE && lookup_attribute("enum_reflect", TYPE_ATTRIBUTES(t)))
+    {
+        note_public_enum(t);
+        return;
+    }
+
+    if ( g_enum_desc_record ) return; // already found
+
     if (TREE_CODE(t) != RECORD_TYPE)
         return;
 
@@ -516,9 +1253,8 @@ static void on_finish_unit(void *, void *)
         return;
     }
 
-    for (hash_set<tree>::iterator it = g_seen_enums.begin(); it != g_seen_enums.end(); ++it)
+    for (tree enum_type : g_enum_order)
     {
-        tree enum_type = *it;
         if (enum_type && TREE_CODE(enum_type) == ENUMERAL_TYPE)
             emit_enum_desc_for(enum_type);
     }
@@ -529,45 +1265,10 @@ static void on_finish_unit(void *, void *)
 
 static tree tree_translation_unit_decl = NULL_TREE;
 
-static std::map<tree, tree> g_enumtype_to_descvar;
-
 static inline bool pointer_type_p(tree t) {
   return t && TREE_CODE(t) == POINTER_TYPE;
 }
 
-static inline bool decl_name_is(tree fndecl, const char *name) {
-  if (!fndecl || TREE_CODE(fndecl) != FUNCTION_DECL) return false;
-  tree id = DECL_NAME(fndecl);
-  if (!id || TREE_CODE(id) != IDENTIFIER_NODE) return false;
-  const char *got = IDENTIFIER_POINTER(id);
-  return got && streq(got, name);
-}
-
-static std::string enum_type_basename(tree enum_type) {
-  std::string out;
-
-  tree tn = TYPE_NAME(enum_type);
-  if (tn) {
-    if (TREE_CODE(tn) == TYPE_DECL) {
-      tree id = DECL_NAME(tn);
-      if (id && TREE_CODE(id) == IDENTIFIER_NODE)
-        out = IDENTIFIER_POINTER(id);
-    } else if (TREE_CODE(tn) == IDENTIFIER_NODE) {
-      out = IDENTIFIER_POINTER(tn);
-    }
-  }
-
-  if (out.empty()) {
-    char buf[64];
-    std::snprintf(buf, sizeof(buf), "anon_%p", (void*)enum_type);
-    out = buf;
-  }
-
-  for (char &c : out) {
-    if (c==' '||c==':'||c=='<'||c=='>'||c=='-'||c=='.') c = '_';
-  }
-  return out;
-}
 
 // Create (or reuse) a TU-scope VAR_DECL for the enum descriptor object.
 // IMPORTANT: we set the VAR type to the *pointee* of wrapper return type (struct enum_desc).
@@ -580,7 +1281,7 @@ static tree get_or_make_desc_var(tree enum_type, tree ret_ptr_type) {
   tree desc_type = TREE_TYPE(ret_ptr_type); // struct enum_desc
   if (!desc_type) return NULL_TREE;
 
-  std::string nm = "__enum_desc__" + enum_type_basename(enum_type);
+  std::string nm = "__enum_desc__" + enum_names_for(enum_type).sym;
   tree id = get_identifier(nm.c_str());
 
   tree var = build_decl(BUILTINS_LOCATION, VAR_DECL, id, desc_type);
@@ -597,11 +1298,12 @@ static tree get_or_make_desc_var(tree enum_type, tree ret_ptr_type) {
   return var;
 }
 
-// Extract enum type from arg0 like: (enum T)0
+// Extract enum type from arg0 like: (enum T)0, or (ns::T)0 in C++
 static tree extract_enum_type_from_arg(tree arg0) {
   if (!arg0) return NULL_TREE;
+  STRIP_NOPS(arg0);
   tree t = TREE_TYPE(arg0);
-  if (t && TREE_CODE(t) == ENUMERAL_TYPE) return t;
+  if (t && TREE_CODE(t) == ENUMERAL_TYPE) return TYPE_MAIN_VARIANT(t);
 
   // Sometimes you get a cast node; its type is still the enum.
   // If not, give up (since you accept strict wrapper form anyway).
@@ -620,6 +1322,7 @@ static tree call_arg0(tree call) {
 }
 
 // Rewrite "return enum_desc((enum T)0);" to "return &__enum_desc__T;"
+// C and C++ (free functions, static members, template instantiations).
 static bool rewrite_return_enum_desc(tree fndecl) {
   tree body = DECL_SAVED_TREE(fndecl);
   if (!body) return false;
@@ -636,18 +1339,27 @@ static bool rewrite_return_enum_desc(tree fndecl) {
   auto visit = [&](auto &&self, tree node) -> void {
     if (!node || changed) return;
 
+    // C++ bodies are statement lists, which have no operands
+    if (TREE_CODE(node) == STATEMENT_LIST) {
+      for (tree_stmt_iterator i = tsi_start(node); !tsi_end_p(i) && !changed; tsi_next(&i))
+        self(self, tsi_stmt(i));
+      return;
+    }
+    if (!EXPR_P(node)) return;
+
     if (TREE_CODE(node) == RETURN_EXPR) {
       tree op0 = TREE_OPERAND(node, 0);
 
-      // Common C GENERIC form:
-      // RETURN_EXPR (MODIFY_EXPR (RESULT_DECL, <rhs>))
-      if (op0 && TREE_CODE(op0) == MODIFY_EXPR) {
+      // C GENERIC form:   RETURN_EXPR (MODIFY_EXPR (RESULT_DECL, <rhs>))
+      // C++ GENERIC form: RETURN_EXPR (INIT_EXPR (RESULT_DECL, <rhs>)), rhs may carry a NOP_EXPR
+      if (op0 && (TREE_CODE(op0) == MODIFY_EXPR || TREE_CODE(op0) == INIT_EXPR)) {
         tree rhs = TREE_OPERAND(op0, 1);
+        STRIP_NOPS(rhs);
         if (rhs && TREE_CODE(rhs) == CALL_EXPR) {
           tree callee = CALL_EXPR_FN(rhs);
           if (callee && TREE_CODE(callee) == ADDR_EXPR)
             callee = TREE_OPERAND(callee, 0);
-          if (decl_name_is(callee, kReflectFnName)) {
+          if (is_reflect_fn(callee)) {
             tree arg0 = call_arg0(rhs);
             tree enum_type = extract_enum_type_from_arg(arg0);
             if (!enum_type) return;
@@ -656,8 +1368,8 @@ static bool rewrite_return_enum_desc(tree fndecl) {
             tree var = get_or_make_desc_var(enum_type, ret_type);
             if (!var) return;
 
-            g_seen_enums.add(enum_type); // remember for emission later
-            dprintf("%s: swap %s -> %s\n", __func__, fndecl_name_cstr(fndecl), fndecl_name_cstr(var)) ;
+            note_enum(enum_type); // remember for emission later
+            dprintf("%s: swap to %s\n", __func__, IDENTIFIER_POINTER(DECL_NAME(var)));
 
             // Build &var (type: pointer-to-desc_type)
             tree addr = build1(ADDR_EXPR, build_pointer_type(TREE_TYPE(var)), var);
@@ -692,16 +1404,33 @@ static bool rewrite_return_enum_desc(tree fndecl) {
 static void on_finish_parse_function(void *event_data, void *) {
   tree fndecl = (tree)event_data;
   if (!fndecl || TREE_CODE(fndecl) != FUNCTION_DECL) return;
+  if (is_reflect_fn(fndecl)) g_reflect_declared = true;
+  // No wrapper can call it before it is declared.
+  if (!g_reflect_declared) return;
+
+  // Template patterns are rewritten per instantiation, never in the pattern itself.
+  if (in_template_pattern(fndecl)) return;
 
   // Only rewrite if the function returns a pointer (your enum_desc_t).
   tree fn_type = TREE_TYPE(fndecl);
-  if (!fn_type || TREE_CODE(fn_type) != FUNCTION_TYPE) return;
+  if (!fn_type || (TREE_CODE(fn_type) != FUNCTION_TYPE && TREE_CODE(fn_type) != METHOD_TYPE)) return;
   tree ret_type = TREE_TYPE(fn_type);
   if (!pointer_type_p(ret_type)) return;
 
+  g_stats.fe_functions++;
   rewrite_return_enum_desc(fndecl);
 }
 
+static void on_finish_decl(void *event_data, void *) {
+  if (is_reflect_fn((tree)event_data)) g_reflect_declared = true;
+}
+
+static void on_finish(void *, void *) {
+  if (!g_print_stats) return;
+  fprintf(stderr, "enum_reflect: %lu bodies walked, %lu functions, %lu call edges, %lu sites\n",
+          g_stats.fe_functions, g_stats.functions, g_stats.call_edges, g_stats.sites);
+}
+
 
 ///===
 
@@ -713,13 +1442,51 @@ int plugin_init(struct plugin_name_args *plugin_info,
     if (!plugin_default_version_check(version, &gcc_version))
         return 1;
 
-    // Capture struct enum_desc type if visible
+    for (int i = 0; i < plugin_info->argc; i++)
+    {
+        const struct plugin_argument &arg = plugin_info->argv[i];
+        if (arg.value && streq(arg.key, "trie-min"))
+            g_trie_min_count = strtoul(arg.value, NULL, 10);
+        else if (arg.value && streq(arg.key, "trie-labels-min"))
+            g_trie_labels_min_bytes = strtoul(arg.value, NULL, 10);
+        else if (arg.value && streq(arg.key, "label-set"))
+        {
+            // wire:strip-prefix+lower
+            const char *colon = strchr(arg.value, ':');
+            label_set_spec spec;
+            spec.name.assign(arg.value, colon ? colon - arg.value : strlen(arg.value));
+            for (const char *t = colon ? colon + 1 : NULL; t && *t; )
+            {
+                size_t len = strcspn(t, "+");
+                std::string name(t, len);
+                if (name == "strip-prefix") spec.transforms.push_back(LSET_STRIP_PREFIX);
+                else if (name == "lower") spec.transforms.push_back(LSET_LOWER);
+                else if (name == "upper") spec.transforms.push_back(LSET_UPPER);
+                else error("enum_reflect plugin: unknown label-set transform %qs", name.c_str());
+                t += len + (t[len] == '+');
+            }
+            if (spec.name.empty())
+                error("enum_reflect plugin: label-set needs a name");
+            else
+                g_label_sets.push_back(spec);
+        }
+        else if (streq(arg.key, "stats"))
+            g_print_stats = true;
+        else
+            warning(0, "enum_reflect plugin: unknown argument %qs", arg.key);
+    }
+    g_reflect_id = get_identifier(kReflectFnName);
+
+    register_callback(plugin_info->base_name, PLUGIN_ATTRIBUTES, on_register_attributes, NULL);
+
+    // Capture struct enum_desc type and attributed enums
     register_callback(plugin_info->base_name, PLUGIN_FINISH_TYPE, on_finish_type, NULL);
 
     register_callback(plugin_info->base_name,
                       PLUGIN_FINISH_PARSE_FUNCTION,
                       on_finish_parse_function,
                       NULL);
+    register_callback(plugin_info->base_name, PLUGIN_FINISH_DECL, on_finish_decl, NULL);
 
     // Emit descriptors at end of TU
     register_callback(plugin_info->base_name, PLUGIN_FINISH_UNIT, on_finish_unit, NULL);
@@ -727,7 +1494,7 @@ int plugin_init(struct plugin_name_args *plugin_info,
     // Install pass
     static struct register_pass_info pass_info;
     pass_info.pass = new enum_refl_pass(g);
-    pass_info.reference_pass_name = "cfg";
+    pass_info.reference_pass_name = "*build_cgraph_edges";
     pass_info.ref_pass_instance_number = 1;
     pass_info.pos_op = PASS_POS_INSERT_AFTER;
 
@@ -735,6 +1502,7 @@ int plugin_init(struct plugin_name_args *plugin_info,
                       PLUGIN_PASS_MANAGER_SETUP,
                       NULL,
                       &pass_info);
+    register_callback(plugin_info->base_name, PLUGIN_FINISH, on_finish, NULL);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "enum_desc_def.h"
+#include "enum_refl.h"
+
+enum color { RED=1, GREEN=2, BLUE=4, WHITE=7 } ;
+
+#define N 100000
+
+static enum_desc_val vals[N], vals2[N] ;
+static const char *labels[N] ;
+
+static void count_runner(void *runner_cxt, int njobs, enum_refl_job_fn job, void *job_cxt)
+{
+    int *calls = runner_cxt ;
+    (*calls)++ ;
+    for (int i=njobs-1 ; i>=0 ; i--) job(job_cxt, i) ;
+}
+
+static void test_bulk_array(enum_desc_t ed, int nthreads)
+{
+    for (int i=0 ; i<N ; i++) vals[i] = i % 997 == 5 ? 99 : (1 << (i%3)) ;
+    size_t unknown[4] ;
+    struct enum_refl_bulk_opts opts = { .nthreads = nthreads, .unknown_idx = unknown, .unknown_max = 4 } ;
+
+    size_t bad = enum_refl_bulk_label_of(ed, vals, N, labels, "?", &opts) ;
+    int ok = 1 ;
+    for (int i=0 ; i<N ; i++) ok &= labels[i] == enum_refl_label_of(ed, vals[i], "?") ;
+    printf("label_of threads=%d unknown=%zu first=%zu,%zu,%zu,%zu: %s\n", nthreads, bad, unknown[0], unknown[1], unknown[2], unknown[3], ok ? "PASS" : "FAIL") ;
+
+    bad = enum_refl_bulk_value_of(ed, labels, N, vals2, -1, &opts) ;
+    ok = 1 ;
+    for (int i=0 ; i<N ; i++) ok &= vals2[i] == (vals[i] == 99 ? -1 : vals[i]) ;
+    printf("value_of threads=%d unknown=%zu first=%zu: %s\n", nthreads, bad, unknown[0], ok ? "PASS" : "FAIL") ;
+}
+
+static void test_bulk_parse(enum_desc_t ed)
+{
+    static char buf[N*8] ;
+    size_t len = 0 ;
+    for (int i=0 ; i<N ; i++) len += sprintf(buf+len, "%s\n", i % 1000 == 3 ? "PINK" : enum_desc_label_at(ed, i%4)) ;
+
+    int calls = 0 ;
+    size_t unknown[2] ;
+    struct enum_refl_bulk_opts opts = { .nthreads = 7, .runner = count_runner, .runner_cxt = &calls, .unknown_idx = unknown, .unknown_max = 2 } ;
+    size_t count = 0 ;
+    size_t bad = enum_refl_bulk_parse(ed, buf, len, '\n', vals2, N, &count, 0, &opts) ;
+    int ok = count == N ;
+    for (int i=0 ; i<N ; i++) ok &= vals2[i] == (i % 1000 == 3 ? 0 : enum_desc_value_at(ed, i%4)) ;
+    printf("parse count=%zu unknown=%zu first=%zu,%zu runner_calls=%d: %s\n", count, bad, unknown[0], unknown[1], calls, ok ? "PASS" : "FAIL") ;
+}
+
+// Tokens are bytes: an embedded NUL is part of the token, never the end of a label.
+static void test_bulk_parse_nul(enum_desc_t ed)
+{
+    static const char buf[] = "RED\0QQQQQ\nBLUE\nB\0LUE_AND_SOME_MORE_BYTES_PAST_THE_LABELS\nWHITE" ;
+    enum_desc_val out[4] ;
+    size_t count = 0 ;
+    size_t bad = enum_refl_bulk_parse(ed, buf, sizeof(buf) - 1, '\n', out, 4, &count, -1, NULL) ;
+    int ok = count == 4 && bad == 2 && out[0] == -1 && out[1] == BLUE && out[2] == -1 && out[3] == WHITE ;
+    printf("parse nul count=%zu unknown=%zu: %s\n", count, bad, ok ? "PASS" : "FAIL") ;
+}
+
+static int hook_calls ;
+
+static enum_desc_idx find_nocase(enum_desc_t ed, const char *label)
+{
+    hook_calls++ ;
+    for (int i=0 ; i<enum_desc_value_count(ed) ; i++) if ( !strcasecmp(enum_desc_label_at(ed, i), label) ) return i ;
+    return ENUM_DESC_NOT_FOUND ;
+}
+
+// A custom find_by_label gets terminated tokens, including ones past the stack buffer.
+static void test_bulk_parse_hook(void)
+{
+    static const struct enum_desc_ext ext = { .find_by_label = find_nocase, .find_by_value = enum_desc_find_by_value } ;
+    enum_desc_t ed = enum_refl_build("color", (struct enum_desc_entry []) { { RED, "RED" }, { BLUE, "BLUE" }, {} }, &ext) ;
+    char buf[400] ;
+    int len = sprintf(buf, "red\n%0300d\nBlue\n", 0) ;
+    enum_desc_val out[3] ;
+    size_t count = 0 ;
+    size_t bad = enum_refl_bulk_parse(ed, buf, len, '\n', out, 3, &count, -1, NULL) ;
+    int ok = count == 3 && bad == 1 && out[0] == RED && out[1] == -1 && out[2] == BLUE && hook_calls == 3 ;
+    printf("parse hook count=%zu unknown=%zu calls=%d: %s\n", count, bad, hook_calls, ok ? "PASS" : "FAIL") ;
+    enum_desc_destroy(ed) ;
+}
+
+int main(int argc, char **argv)
+{
+    enum_desc_t ed = enum_refl_build("color", (struct enum_desc_entry []) { { RED, "RED" }, { GREEN, "GREEN" }, { BLUE, "BLUE" }, { WHITE, "WHITE" }, {} }, NULL) ;
+    test_bulk_array(ed, 1) ;
+    test_bulk_array(ed, 4) ;
+    test_bulk_parse(ed) ;
+    test_bulk_parse_nul(ed) ;
+    test_bulk_parse_hook() ;
+    enum_desc_destroy(ed) ;
+}
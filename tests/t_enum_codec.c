@@ -0,0 +1,86 @@
+#include <stdio.h>
+
+#include "enum_refl.h"
+#include "enum_desc_codec.h"
+
+enum s1 { AAA=100, BBB, CCC, DDD, EEE, FFF=200, GGG, HHH, III, JJJ, KKK=300, LLL, MMM, NNN, OOO, PPP=400, QQQ, RRR, SSS, TTT, UUU=500, VVV, WWW, XXX, YYY, ZZZ} ;
+
+#define N 100003
+#define WIDE 300
+
+static unsigned rnd_state = 12345 ;
+static unsigned rnd(void)
+{
+    rnd_state = rnd_state * 1103515245 + 12345 ;
+    return rnd_state >> 8 ;
+}
+
+// Encode, decode whole and at odd offsets, compare with the input.
+static void round_trip(enum_desc_t ed, const enum_desc_val *vals, size_t n)
+{
+    enum_desc_codec_t c = enum_desc_codec_create(ed, -1) ;
+    size_t size = enum_desc_codec_size(c, n) ;
+    uint8_t *packed = malloc(size) ;
+    enum_desc_val *out = malloc(n * sizeof(*out)) ;
+    size_t unknown = enum_desc_codec_encode(c, vals, n, packed) ;
+    size_t decoded_unknown = enum_desc_codec_decode(c, packed, size, 0, n, out) ;
+    size_t bad = 0 ;
+    for (size_t i=0 ; i<n ; i++) bad += out[i] != (enum_desc_is_valid(ed, vals[i]) ? vals[i] : -1) ;
+    for (size_t first=1 ; first<n ; first=first*3+1) {
+        size_t len = n - first < 37 ? n - first : 37 ;
+        enum_desc_codec_decode(c, packed, size, first, len, out) ;
+        for (size_t i=0 ; i<len ; i++) bad += out[i] != (enum_desc_is_valid(ed, vals[first+i]) ? vals[first+i] : -1) ;
+    }
+    // Chunks of whole blocks concatenate to the same bytes
+    uint8_t *chunked = malloc(size) ;
+    size_t chunk = 5 * ENUM_DESC_CODEC_BLOCK, done = 0 ;
+    for ( ; done<n ; done+=chunk)
+        enum_desc_codec_encode(c, vals + done, n - done < chunk ? n - done : chunk, chunked + enum_desc_codec_size(c, done)) ;
+    printf("%s: n=%zu bits=%d bytes=%zu (%.1fx) unknown=%zu/%zu mismatches=%zu chunked=%s past end=%d\n", enum_desc_name(ed), n,
+        enum_desc_codec_bits(c), size, (double) (n * sizeof(enum_desc_val)) / size, unknown, decoded_unknown, bad,
+        memcmp(packed, chunked, size) ? "differ" : "same", (int) enum_desc_codec_decode(c, packed, size, n - 1, ENUM_DESC_CODEC_BLOCK, out)) ;
+    free(chunked) ;
+    free(out) ;
+    free(packed) ;
+    enum_desc_codec_destroy(c) ;
+}
+
+int main(int argc, char **argv)
+{
+    enum_desc_t ed = enum_refl_build("s1", (struct enum_desc_entry []) {
+        { AAA, "AAA" }, { BBB, "BBB" }, { CCC, "CCC" }, { DDD, "DDD" }, { EEE, "EEE" }, { FFF, "FFF" }, { GGG, "GGG" },
+        { HHH, "HHH" }, { III, "III" }, { JJJ, "JJJ" }, { KKK, "KKK" }, { LLL, "LLL" }, { MMM, "MMM" }, { NNN, "NNN" },
+        { OOO, "OOO" }, { PPP, "PPP" }, { QQQ, "QQQ" }, { RRR, "RRR" }, { SSS, "SSS" }, { TTT, "TTT" }, { UUU, "UUU" },
+        { VVV, "VVV" }, { WWW, "WWW" }, { XXX, "XXX" }, { YYY, "YYY" }, { ZZZ, "ZZZ" }, {} }, NULL) ;
+    enum_desc_val *vals = malloc(N * sizeof(*vals)) ;
+    for (int i=0 ; i<N ; i++) vals[i] = enum_desc_value_at(ed, rnd() % 26) ;
+    vals[7] = 42 ;
+    vals[N-1] = 999 ;
+    round_trip(ed, vals, N) ;
+    round_trip(ed, vals, 5) ;
+
+    // Aliases decode to the shared value
+    enum_desc_t flag = enum_refl_build("flag", (struct enum_desc_entry []) { { 0, "OFF" }, { 1, "ON" }, { 1, "YES" }, {} }, NULL) ;
+    for (int i=0 ; i<N ; i++) vals[i] = rnd() & 1 ;
+    round_trip(flag, vals, N) ;
+    enum_desc_t one = enum_refl_build("one", (struct enum_desc_entry []) { { 7, "ONLY" }, {} }, NULL) ;
+    for (int i=0 ; i<N ; i++) vals[i] = i % 100 ? 7 : 8 ;
+    round_trip(one, vals, N) ;
+
+    static struct enum_desc_entry entries[WIDE+1] ;
+    static char names[WIDE][8] ;
+    for (int i=0 ; i<WIDE ; i++) {
+        snprintf(names[i], sizeof(names[i]), "W%d", i) ;
+        entries[i] = (struct enum_desc_entry) { i * 1000 - 5000, names[i] } ;
+    }
+    enum_desc_t wide = enum_refl_build("wide", entries, NULL) ;
+    for (int i=0 ; i<N ; i++) vals[i] = (int) (rnd() % WIDE) * 1000 - 5000 ;
+    round_trip(wide, vals, N) ;
+
+    free(vals) ;
+    enum_desc_destroy(wide) ;
+    enum_desc_destroy(one) ;
+    enum_desc_destroy(flag) ;
+    enum_desc_destroy(ed) ;
+    return 0 ;
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "enum_refl.h"
+#include "enum_desc_counter.h"
+
+enum msg { MSG_HELLO=1, MSG_DATA=2, MSG_ACK=3, MSG_BYE=9, MSG_PING=2 } ;
+
+#define NTHREADS 4
+#define N 100000
+
+static enum_desc_counter_t counter ;
+static atomic_int writers_done ;
+
+static void *writer(void *arg)
+{
+    // Per thread: N/2 DATA, N/4 ACK, N/8 HELLO, N/8 unknown (42)
+    for (int i=0 ; i<N ; i++) {
+        static const enum_desc_val pattern[8] = { MSG_DATA, MSG_ACK, MSG_DATA, MSG_HELLO, MSG_DATA, MSG_ACK, MSG_DATA, 42 } ;
+        enum_desc_counter_inc(counter, pattern[i % 8]) ;
+    }
+    return NULL ;
+}
+
+static void *reader(void *arg)
+{
+    int *monotonic = arg ;
+    uint64_t prev[6] = { 0 }, cur[6] ;
+    while ( !writers_done ) {
+        enum_desc_counter_snapshot(counter, cur) ;
+        for (int i=0 ; i<6 ; i++) {
+            if ( cur[i] < prev[i] ) *monotonic = 0 ;
+            prev[i] = cur[i] ;
+        }
+    }
+    return NULL ;
+}
+
+int main(int argc, char **argv)
+{
+    enum_desc_t ed = enum_refl_build("msg", (struct enum_desc_entry []) {
+        { MSG_HELLO, "MSG_HELLO" }, { MSG_DATA, "MSG_DATA" }, { MSG_ACK, "MSG_ACK" }, { MSG_BYE, "MSG_BYE" }, { MSG_PING, "MSG_PING" }, {} }, NULL) ;
+
+    counter = enum_desc_counter_create(ed) ;
+    enum_desc_counter_add(counter, MSG_BYE, 5) ;
+    pthread_t tids[NTHREADS], rtid ;
+    int monotonic = 1 ;
+    pthread_create(&rtid, NULL, reader, &monotonic) ;
+    for (int t=0 ; t<NTHREADS ; t++) pthread_create(&tids[t], NULL, writer, NULL) ;
+    for (int t=0 ; t<NTHREADS ; t++) pthread_join(tids[t], NULL) ;
+    writers_done = 1 ;
+    pthread_join(rtid, NULL) ;
+    enum_desc_counter_print(stdout, counter) ;
+
+    uint64_t counts[6] ;
+    enum_desc_counter_snapshot(counter, counts) ;
+    int ok = counts[1] == NTHREADS*N/2 && counts[2] == NTHREADS*N/4 && counts[0] == NTHREADS*N/8
+        && counts[3] == 5 && counts[4] == 0 && counts[5] == NTHREADS*N/8 ;
+    printf("counter snapshot: %s, concurrent reads monotonic: %s\n", ok ? "PASS" : "FAIL", monotonic ? "PASS" : "FAIL") ;
+    enum_desc_counter_destroy(counter) ;
+
+    // A new counter on the same thread starts from 0
+    counter = enum_desc_counter_create(ed) ;
+    enum_desc_counter_inc(counter, MSG_HELLO) ;
+    enum_desc_counter_print(stdout, counter) ;
+    enum_desc_counter_destroy(counter) ;
+    enum_desc_destroy(ed) ;
+    return 0 ;
+}
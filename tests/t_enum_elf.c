@@ -0,0 +1,49 @@
+// Descriptors laid out as the plugin emits them, for enum_desc_inspect (see Makefile).
+#include <stdio.h>
+
+#include "enum_desc_def.h"
+
+enum color { RED, GREEN, BLUE, CYAN, MAGENTA, YELLOW, BLACK, WHITE, GRAY, ORANGE } ;
+enum status { ST_OK=0, ST_WARN=100, ST_FAIL=100000, ST_DEAD=-7 } ;
+
+#define COLOR_COUNT 10
+
+const struct enum_desc __enum_desc__color = {
+    .value_count = COLOR_COUNT,
+    .flags = ENUM_DESC_F_RANGE,
+    .values = (const enum_desc_val[COLOR_COUNT]) { RED, GREEN, BLUE, CYAN, MAGENTA, YELLOW, BLACK, WHITE, GRAY, ORANGE },
+    .lbl_off = (const uint16_t[COLOR_COUNT]) { 6, 10, 16, 21, 26, 34, 41, 47, 53, 58 },
+    .strs = "color\0RED\0GREEN\0BLUE\0CYAN\0MAGENTA\0YELLOW\0BLACK\0WHITE\0GRAY\0ORANGE\0\0\0\0\0\0\0\0",
+    .value_min = RED,
+    .value_max = ORANGE,
+    .value_bits = (const uint32_t[1]) { 0x3ff },
+    .value_rank = (const uint16_t[1]) { 0 },
+    .uniq_count = COLOR_COUNT,
+    .by_value = (const enum_desc_idx[COLOR_COUNT]) { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 },
+    .label_set_count = 1,
+    .label_sets = (const struct enum_desc_label_set[1]) { {
+        .strs = "lower\0red\0green\0blue\0cyan\0magenta\0yellow\0black\0white\0gray\0orange\0\0\0\0\0\0\0\0",
+        .lbl_off = (const uint16_t[COLOR_COUNT]) { 6, 10, 16, 21, 26, 34, 41, 47, 53, 58 },
+    } },
+} ;
+
+const struct enum_desc __enum_desc__status = {
+    .value_count = 4,
+    .flags = ENUM_DESC_F_RANGE,
+    .values = (const enum_desc_val[4]) { ST_OK, ST_WARN, ST_FAIL, ST_DEAD },
+    .lbl_off = (const uint16_t[4]) { 7, 13, 21, 29 },
+    .strs = "status\0ST_OK\0ST_WARN\0ST_FAIL\0ST_DEAD\0\0\0\0\0\0\0\0",
+    .value_min = ST_DEAD,
+    .value_max = ST_FAIL,
+    .uniq_count = 4,
+    .by_value = (const enum_desc_idx[4]) { 3, 0, 1, 2 },
+} ;
+
+int main(int argc, char **argv)
+{
+    enum_desc_print(stdout, &__enum_desc__color, false) ;
+    enum_desc_print(stdout, &__enum_desc__status, false) ;
+    printf("find: %d %d %s\n", enum_desc_find_by_value(&__enum_desc__color, GRAY), enum_desc_find_by_label(&__enum_desc__status, "ST_FAIL"),
+        enum_desc_label_at_set(&__enum_desc__color, 1, enum_desc_find_by_label_set(&__enum_desc__color, 1, "magenta"))) ;
+    return 0 ;
+}
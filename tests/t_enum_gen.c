@@ -0,0 +1,105 @@
+// Descriptors from enum_desc_tablegen (see Makefile), checked against enum_refl_build.
+#include <stdio.h>
+#include <stddef.h>
+
+#include "enum_desc_def.h"
+#include "enum_refl.h"
+#include "t_enum_gen.h"
+
+ENUM_DESC_EXTERN(currency) ;
+ENUM_DESC_EXTERN(color) ;
+ENUM_DESC_EXTERN(mode) ;
+ENUM_DESC_EXTERN(log_level) ;
+ENUM_DESC_EXTERN(opcode) ;
+// Must not be emitted (member enum of a typedef'd struct), NULL when absent.
+extern const struct enum_desc __enum_desc__kind __attribute__((weak)) ;
+
+// Same answers as the run-time builder, through every lookup path.
+static int mismatches(enum_desc_t gen, enum_desc_t ref)
+{
+    int bad = strcmp(enum_desc_name(gen), enum_desc_name(ref)) != 0 ;
+    bad += enum_desc_value_count(gen) != enum_desc_value_count(ref) ;
+    for (int i=0 ; !bad && i<enum_desc_value_count(ref) ; i++) {
+        enum_desc_val v = enum_desc_value_at(ref, i) ;
+        const char *label = enum_desc_label_at(ref, i) ;
+        bad += enum_desc_value_at(gen, i) != v ;
+        bad += strcmp(enum_desc_label_at(gen, i), label) != 0 ;
+        bad += enum_desc_find_by_value(gen, v) != enum_desc_find_by_value(ref, v) ;
+        bad += enum_desc_find_by_label(gen, label) != enum_desc_find_by_label(ref, label) ;
+        bad += enum_desc_is_valid(gen, v + 1) != enum_desc_is_valid(ref, v + 1) ;
+        for (int k=1 ; k<=enum_desc_label_set_count(ref) ; k++) {
+            const char *set_label = enum_desc_label_at_set(ref, k, i) ;
+            bad += strcmp(enum_desc_label_at_set(gen, k, i), set_label) != 0 ;
+            bad += enum_desc_find_by_label_set(gen, k, set_label) != enum_desc_find_by_label_set(ref, k, set_label) ;
+        }
+    }
+    bad += enum_desc_label_set_count(gen) != enum_desc_label_set_count(ref) ;
+    for (int k=0 ; k<enum_desc_label_set_count(ref) ; k++) {
+        bad += (gen->label_sets[k].trie != NULL) != (ref->label_sets[k].trie != NULL) ;
+    }
+    bad += gen->fingerprint != ref->fingerprint || enum_desc_diff(gen, ref, NULL) != 0 ;
+    struct enum_desc_iter ig, ir ;
+    for (int order=ENUM_DESC_ORDER_VALUE ; order<=ENUM_DESC_ORDER_LABEL ; order++) {
+        enum_desc_iter_sorted(gen, order, &ig) ;
+        enum_desc_iter_sorted(ref, order, &ir) ;
+        enum_desc_idx a, b ;
+        do {
+            a = enum_desc_iter_next(&ig) ;
+            b = enum_desc_iter_next(&ir) ;
+            bad += a != b ;
+        } while ( a != ENUM_DESC_NOT_FOUND && b != ENUM_DESC_NOT_FOUND ) ;
+    }
+    return bad ;
+}
+
+// Reference built at run time from the generated labels, with the same "wire" set (see Makefile).
+static void check(enum_desc_t gen)
+{
+    int count = enum_desc_value_count(gen) ;
+    struct enum_desc_entry entries[count+1] ;
+    const char *wire[count+1] ;
+    for (int i=0 ; i<count ; i++) {
+        entries[i] = (struct enum_desc_entry) { enum_desc_value_at(gen, i), enum_desc_label_at(gen, i) } ;
+        wire[i] = enum_desc_label_at_set(gen, 1, i) ;
+    }
+    entries[count] = (struct enum_desc_entry) { 0 } ;
+    struct enum_desc_label_set_def set = { "wire", wire } ;
+    enum_desc_t ref = enum_refl_build_sets(NULL, enum_desc_name(gen), entries, NULL, &set, 1) ;
+    printf("%s: items=%d flags=%d trie=%d alias=%d mismatches=%d\n", enum_desc_name(gen), count, gen->flags,
+        gen->trie != NULL, gen->alias_next != NULL, mismatches(gen, ref)) ;
+    enum_desc_destroy(ref) ;
+}
+
+int main(int argc, char **argv)
+{
+    static const enum_desc_t descs[] = {
+        ENUM_DESC_REF(currency), ENUM_DESC_REF(color), ENUM_DESC_REF(mode), ENUM_DESC_REF(log_level), ENUM_DESC_REF(opcode),
+    } ;
+    for (int k=0 ; k<sizeof(descs)/sizeof(descs[0]) ; k++) check(descs[k]) ;
+
+    // Same single object layout as the plugin
+    enum_desc_t cur = ENUM_DESC_REF(currency) ;
+    const char *base = (const char *) cur ;
+    printf("layout: aligned=%d values=%d lbl_off=%d strs=%d\n", (int) ((uintptr_t) base % 64 == 0),
+        (int) ((const char *) cur->values - base), (int) ((const char *) cur->lbl_off - base), (int) (cur->strs - base)) ;
+    // Fields a value lookup or label_at reads end at the first cache line
+    printf("header: size=%d lookup_end=%d\n", (int) sizeof(struct enum_desc), (int) (offsetof(struct enum_desc, by_value) + sizeof(cur->by_value))) ;
+    enum_desc_print(stdout, cur, 1) ;
+
+    const enum_desc_t mode = ENUM_DESC_REF(mode) ;
+    for (int i=0 ; i<enum_desc_value_count(mode) ; i++) printf("%s=%d ", enum_desc_label_at(mode, i), enum_desc_value_at(mode, i)) ;
+    printf("\n") ;
+    printf("color GRAY=%d log_level %s opcode %s\n", enum_desc_find_by_label(ENUM_DESC_REF(color), "GRAY"),
+        enum_desc_label_at(ENUM_DESC_REF(log_level), enum_desc_find_by_value(ENUM_DESC_REF(log_level), LVL_WARN)),
+        enum_desc_label_at(ENUM_DESC_REF(opcode), enum_desc_find_by_value(ENUM_DESC_REF(opcode), 0x11))) ;
+    // Built with -l wire:strip-prefix+lower
+    const enum_desc_t level = ENUM_DESC_REF(log_level) ;
+    printf("set %s:", enum_desc_label_set_name(level, 1)) ;
+    for (int i=0 ; i<enum_desc_value_count(level) ; i++) printf(" %s", enum_desc_label_at_set(level, 1, i)) ;
+    printf(" find(warn)=%d trie(color)=%d\n", enum_desc_find_by_label_set(level, 1, "warn"), ENUM_DESC_REF(color)->label_sets[0].trie != NULL) ;
+    printf("member enum kind: %s\n", &__enum_desc__kind ? "emitted" : "not emitted") ;
+    // Generated descriptors are static, destroy leaves them alone
+    enum_desc_destroy(cur) ;
+    printf("after destroy: %s %d\n", enum_desc_name(cur), enum_desc_value_count(cur)) ;
+    return 0 ;
+}
@@ -0,0 +1,32 @@
+// Enums for enum_desc_tablegen, read after the preprocessor (see Makefile).
+#ifndef _T_ENUM_GEN_H_
+#define _T_ENUM_GEN_H_
+
+#define BASE 0x10
+
+enum currency { USD=840, EUR=978, JPY=826, GBP=826, AUD=36 } ;
+
+enum color { RED, GREEN, BLUE, CYAN, MAGENTA, YELLOW, BLACK, WHITE, GRAY, ORANGE } ;
+
+// Earlier enumerators, casts and operators in initializers.
+enum __attribute__((packed)) mode {
+    MODE_READ = 1 << 0,
+    MODE_WRITE = 1 << 1,
+    MODE_RW = MODE_READ | MODE_WRITE,
+    MODE_EXEC = (int) BASE,
+    MODE_ALL = MODE_RW | MODE_EXEC,
+    MODE_CHAR = 'x',
+    MODE_NEG = -(MODE_ALL * 2) + 1,
+    MODE_PICK = MODE_EXEC > 8 && !MODE_CHAR == 0 ? 100 : 200,
+} ;
+
+typedef enum { LVL_DEBUG=-1, LVL_INFO, LVL_WARN, LVL_ERROR } log_level ;
+
+// Anonymous member enum: kind is a member, not a typedef name, nothing to emit.
+typedef struct { enum { K_A, K_B } kind ; int x ; } tagged ;
+
+// Not definitions, nothing to emit.
+enum currency last_currency(void) ;
+enum { ANON_A = 7 } ;
+
+#endif
@@ -0,0 +1,48 @@
+#include <stdio.h>
+
+#include "enum_refl.h"
+#include "enum_desc_index.h"
+
+enum status { OK=0, FAILED=1, PENDING=2 } ;
+enum http_status { HTTP_OK=200, NOT_FOUND=404 } ;
+enum job_state { QUEUED=10, RUNNING=11, DONE=12 } ;
+
+static void show(enum_desc_index_t index, const char *label)
+{
+    const struct enum_desc_match *m ;
+    int n = enum_desc_index_lookup(index, label, strlen(label), &m) ;
+    printf("lookup(%s)=%d", label, n) ;
+    for (int i=0 ; i<n ; i++) printf(" %s.%d=%d", enum_desc_name(m[i].ed), m[i].idx, enum_desc_value_at(m[i].ed, m[i].idx)) ;
+    printf("\n") ;
+}
+
+int main(int argc, char **argv)
+{
+    enum_desc_t eds[4] = {
+        enum_refl_build("status", (struct enum_desc_entry []) { { OK, "OK" }, { FAILED, "FAILED" }, { PENDING, "PENDING" }, {} }, NULL),
+        enum_refl_build("http_status", (struct enum_desc_entry []) { { HTTP_OK, "OK" }, { NOT_FOUND, "NOT_FOUND" }, {} }, NULL),
+        enum_refl_build("job_state", (struct enum_desc_entry []) { { QUEUED, "QUEUED" }, { RUNNING, "RUNNING" }, { DONE, "DONE" }, { 13, "FAILED" }, {} }, NULL),
+    } ;
+    eds[3] = eds[0] ;
+    enum_desc_index_t index = enum_desc_index_build(eds, 4) ;
+    show(index, "OK") ;
+    show(index, "FAILED") ;
+    show(index, "RUNNING") ;
+    show(index, "RUN") ;
+    show(index, "MISSING") ;
+    {
+        const char *buf = "NOT_FOUND,OK" ;
+        const struct enum_desc_match *m ;
+        int n = enum_desc_index_lookup(index, buf, 9, &m) ;
+        printf("lookup(buf[0:9])=%d %s\n", n, n ? enum_desc_name(m[0].ed) : "-") ;
+    }
+    enum_desc_index_destroy(index) ;
+
+    int count ;
+    enum_desc_registry(&count) ;
+    index = enum_desc_index_build_registry() ;
+    printf("registry=%d lookup(OK)=%d\n", count, enum_desc_index_lookup(index, "OK", 2, NULL)) ;
+    enum_desc_index_destroy(index) ;
+
+    for (int i=0 ; i<3 ; i++) enum_desc_destroy(eds[i]) ;
+}
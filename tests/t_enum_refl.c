@@ -1,6 +1,9 @@
 #include <stdio.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include "enum_refl.h"
+#include "enum_desc_inline.h"
 
 enum e1 { E1=1, E3=3, E100=100} ;
 
@@ -56,8 +59,468 @@ static void test_dynamic_refl(void)
 }
 
 
+static void test_valid(enum_desc_t ed)
+{
+    enum_desc_val vals[40] ;
+    for (int i=0 ; i<40 ; i++) vals[i] = enum_desc_value_at(ed, i % enum_desc_value_count(ed)) ;
+    size_t bad = 0 ;
+    int all_ok = enum_desc_validate(ed, vals, 40, &bad) ;
+    vals[37] = 2 ;
+    int one_bad = !enum_desc_validate(ed, vals, 40, &bad) && bad == 37 ;
+    printf("valid(%s): E3=%d 2=%d -30=%d 12345=%d validate=%s\n", enum_desc_name(ed),
+        enum_desc_is_valid(ed, E3), enum_desc_is_valid(ed, 2), enum_desc_is_valid(ed, VV3), enum_desc_is_valid(ed, VV4),
+        all_ok && one_bad ? "PASS" : "FAIL") ;
+}
+
+static void test_dynamic_valid(void)
+{
+    enum_desc_t e1_desc = enum_refl_build("e1", (struct enum_desc_entry []) { { E1, "E1"}, { E3, "E3" }, { E100, "E100"}, {} }, NULL) ;
+    enum_desc_t s2_wide = enum_refl_build("s2", (struct enum_desc_entry []) { { VV1, "VV1"}, { VV2, "VV2" }, { VV3, "VV3"}, { VV4, "VV4"}, {} }, NULL) ;
+    test_valid(e1_desc) ;
+    test_valid(s2_wide) ;
+    test_valid(&s2_desc) ;
+    enum_desc_destroy(s2_wide) ;
+    enum_desc_destroy(e1_desc) ;
+}
+
+enum currency { USD=840, EUR=978, JPY=826, GBP=826, AUD=36 } ;
+
+static void test_aliases(void)
+{
+    enum_desc_t ed = enum_refl_build("currency", (struct enum_desc_entry []) {
+        { USD, "USD" }, { EUR, "EUR" }, { JPY, "JPY" }, { GBP, "GBP" }, { AUD, "AUD" }, {} }, NULL) ;
+    enum_desc_idx idx[4] ;
+    int n = enum_desc_aliases_of(ed, GBP, idx, 4) ;
+    printf("aliases(826)=%d: %s %s\n", n, enum_desc_label_at(ed, idx[0]), enum_desc_label_at(ed, idx[1])) ;
+    printf("aliases(840)=%d aliases(1)=%d\n", enum_desc_aliases_of(ed, USD, idx, 4), enum_desc_aliases_of(ed, 1, idx, 4)) ;
+    printf("label(826)=%s label(36)=%s label(978)=%s\n", enum_refl_label_of(ed, 826, "?"), enum_refl_label_of(ed, 36, "?"), enum_refl_label_of(ed, 978, "?")) ;
+    enum_desc_destroy(ed) ;
+}
+
+static void test_label_ptr(enum_desc_t ed)
+{
+    int ok = 1 ;
+    for (int i=0 ; i<enum_desc_value_count(ed) ; i++) {
+        const char *label = enum_refl_label_of(ed, enum_desc_value_at(ed, i), NULL) ;
+        char copy[32] ;
+        strcpy(copy, label) ;
+        ok &= enum_desc_index_of_label_ptr(ed, label) == i && enum_desc_index_of_label_ptr(ed, copy) == i ;
+    }
+    ok &= enum_desc_index_of_label_ptr(ed, enum_desc_name(ed)) == ENUM_DESC_NOT_FOUND ;
+    ok &= enum_desc_index_of_label_ptr(ed, enum_desc_label_at(ed, 0) + 1) == ENUM_DESC_NOT_FOUND ;
+    printf("label_ptr(%s): %s\n", enum_desc_name(ed), ok ? "PASS" : "FAIL") ;
+}
+
+static void test_cache(void)
+{
+    struct enum_refl_cache_stats st ;
+    enum_refl_cache_enable(true) ;
+    enum_refl_cache_stats(NULL, true) ;
+    enum_desc_t ed = enum_refl_build("e1", (struct enum_desc_entry []) { { E1, "E1"}, { E3, "E3" }, { E100, "E100"}, {} }, NULL) ;
+    for (int i=0 ; i<100 ; i++) enum_refl_label_of(ed, i < 50 ? E3 : E100, "?") ;
+    enum_refl_cache_stats(&st, false) ;
+    printf("cache: hits=%d misses=%d\n", (int) st.hits, (int) st.misses) ;
+    // Destroying another descriptor keeps these entries.
+    enum_desc_destroy(enum_refl_build("other", (struct enum_desc_entry []) { { E1, "E1"}, {} }, NULL)) ;
+    enum_refl_label_of(ed, E3, "?") ;
+    enum_refl_cache_stats(&st, false) ;
+    printf("cache: after other destroy hits=%d misses=%d\n", (int) st.hits, (int) st.misses) ;
+    enum_desc_destroy(ed) ;
+
+    // Same entries, different values: must not hit the old entries.
+    ed = enum_refl_build("e1", (struct enum_desc_entry []) { { E1, "E100"}, { E3, "E1" }, { E100, "E3"}, {} }, NULL) ;
+    printf("cache: label(3)=%s label(100)=%s\n", enum_refl_label_of(ed, E3, "?"), enum_refl_label_of(ed, E100, "?")) ;
+    enum_refl_cache_stats(&st, true) ;
+    printf("cache: hits=%d misses=%d\n", (int) st.hits, (int) st.misses) ;
+    enum_desc_destroy(ed) ;
+    enum_refl_cache_enable(false) ;
+}
+
+// Labels sharing prefixes, some a prefix of another.
+static void check_trie(enum_desc_t ed, const char *const *labels, int n)
+{
+    int ok = ed->trie != NULL ;
+    char buf[64] ;
+    for (int i=0 ; i<n && ok ; i++) {
+        ok &= enum_desc_find_by_label(ed, labels[i]) == i ;
+        ok &= enum_desc_find_by_label_n(ed, labels[i], strlen(labels[i])) == i ;
+        ok &= enum_desc_label_copy(ed, i, buf, sizeof(buf)) == (int) strlen(labels[i]) && !strcmp(buf, labels[i]) ;
+        snprintf(buf, sizeof(buf), "%sX", labels[i]) ;
+        ok &= enum_desc_find_by_label(ed, buf) == ENUM_DESC_NOT_FOUND ;
+        ok &= enum_desc_find_by_label_n(ed, buf, strlen(buf)-2) != i ;
+    }
+    ok &= enum_desc_label_copy(ed, n-1, buf, 2) == (int) strlen(labels[n-1]) && strlen(buf) == 1 ;
+    ok &= enum_desc_label_copy(ed, enum_desc_value_count(ed), buf, sizeof(buf)) == -1 ;
+    for (int i=0 ; i<n && ok ; i++) ok &= !strcmp(enum_desc_label_at(ed, i), labels[i]) ;
+    printf("trie(%s): nodes=%d trie_labels=%d %s\n", enum_desc_name(ed), ed->trie ? ed->trie->node_count : 0,
+        !!(ed->flags & ENUM_DESC_F_TRIE_LABELS), ok ? "PASS" : "FAIL") ;
+}
+
+static void test_trie(void)
+{
+    static const char *const small[] = { "ERR", "ERR_IO", "ERR_IO_READ", "ERR_IO_WRITE", "ERR_NET", "ERR_NET_DNS", "OK", "ERR_IO", "WARN", "W" } ;
+    enum { NSMALL = sizeof(small)/sizeof(small[0]), NBIG = 300 } ;
+    struct enum_desc_entry entries[NBIG+1] = { 0 } ;
+    for (int i=0 ; i<NSMALL ; i++) entries[i] = (struct enum_desc_entry) { .value = i, .name = small[i] } ;
+    enum_desc_t ed = enum_refl_build("status", entries, NULL) ;
+    // Duplicate label: lookups give the first one.
+    static const char *const small_first[] = { "ERR", "ERR_IO", "ERR_IO_READ", "ERR_IO_WRITE", "ERR_NET", "ERR_NET_DNS", "OK" } ;
+    check_trie(ed, small_first, 7) ;
+    enum_desc_destroy(ed) ;
+
+    static char names[NBIG][32] ;
+    const char *labels[NBIG] ;
+    for (int i=0 ; i<NBIG ; i++) {
+        snprintf(names[i], sizeof(names[i]), "METRIC_HTTP_%s_%d", i % 3 ? "REQ" : "RESP", i) ;
+        labels[i] = names[i] ;
+        entries[i] = (struct enum_desc_entry) { .value = 1000+i, .name = names[i] } ;
+    }
+    entries[NBIG] = (struct enum_desc_entry) { 0 } ;
+    ed = enum_refl_build("metric", entries, NULL) ;
+    printf("trie(metric): label(1007)=%s\n", enum_refl_label_of(ed, 1007, "?")) ;
+    check_trie(ed, labels, NBIG) ;
+    test_label_ptr(ed) ;
+    enum_desc_destroy(ed) ;
+}
+
+// One letter per byte: N need more, P prefix, F full, R reject.
+static void feed_bytes(enum_desc_t ed, const char *token)
+{
+    struct enum_desc_matcher m ;
+    char states[64] = "" ;
+    enum_desc_matcher_init(&m, ed) ;
+    for (int i=0 ; token[i] ; i++) states[i] = "NPFR"[enum_desc_matcher_feed(&m, token + i, 1)] ;
+    printf("match(%s, %s): %s -> %d\n", enum_desc_name(ed), token, states, enum_desc_matcher_finish(&m)) ;
+}
+
+static void test_matcher(void)
+{
+    static const char *const small[] = { "ERR", "ERR_IO", "ERR_IO_READ", "ERR_IO_WRITE", "ERR_NET", "ERR_NET_DNS", "OK", "ERR_IO", "WARN", "W" } ;
+    struct enum_desc_entry entries[11] = { 0 } ;
+    for (int i=0 ; i<10 ; i++) entries[i] = (struct enum_desc_entry) { .value = i, .name = small[i] } ;
+    enum_desc_t with_trie = enum_refl_build("status", entries, NULL) ;
+    entries[ENUM_DESC_TRIE_MIN_COUNT-1] = (struct enum_desc_entry) { 0 } ;
+    enum_desc_t no_trie = enum_refl_build("status7", entries, NULL) ;
+
+    enum_desc_t eds[] = { with_trie, no_trie } ;
+    for (int k=0 ; k<2 ; k++) {
+        feed_bytes(eds[k], "ERR_IO") ;
+        feed_bytes(eds[k], "ERR_NET_DNS") ;
+        feed_bytes(eds[k], "ERR_NX") ;
+        feed_bytes(eds[k], "OK!") ;
+        feed_bytes(eds[k], "W") ;
+        // Token split over reads
+        struct enum_desc_matcher m ;
+        enum_desc_matcher_init(&m, eds[k]) ;
+        enum_desc_matcher_feed(&m, "ERR_IO_", 7) ;
+        int st = enum_desc_matcher_feed(&m, "WRITE", 5) ;
+        printf("match(%s, ERR_IO_|WRITE): state=%d idx=%d\n", enum_desc_name(eds[k]), st, enum_desc_matcher_finish(&m)) ;
+    }
+    enum_desc_destroy(no_trie) ;
+    enum_desc_destroy(with_trie) ;
+}
+
+// 300 long labels, past ENUM_DESC_TRIE_LABELS_MIN_BYTES: labels stored only in the trie.
+// TENANT_SCHEMA_FIELD_<i> = 3*i
+static enum_desc_t build_fields(enum_desc_arena_t arena)
+{
+    static char names[300][32] ;
+    struct enum_desc_entry entries[301] = { 0 } ;
+    for (int i=0 ; i<300 ; i++) {
+        snprintf(names[i], sizeof(names[i]), "TENANT_SCHEMA_FIELD_%d", i) ;
+        entries[i] = (struct enum_desc_entry) { .value = 3*i, .name = names[i] } ;
+    }
+    return enum_refl_build_in(arena, "fields", entries, NULL) ;
+}
+
+static void test_arena(void)
+{
+    enum_desc_arena_t arena = enum_desc_arena_create(0) ;
+    enum_desc_t big = build_fields(arena) ;
+    enum_desc_t eds[100] ;
+    int ok = 1 ;
+    for (int k=0 ; k<100 ; k++) {
+        eds[k] = enum_refl_build_in(arena, "e1", (struct enum_desc_entry []) { { E1, "E1"}, { E3, "E3" }, { E100, "E100"}, {} }, NULL) ;
+        ok &= (eds[k]->flags & ENUM_DESC_F_ARENA) && (const char *) eds[k]->values > (const char *) eds[k] ;
+    }
+    enum_desc_destroy(eds[0]) ;            // no-op
+    ok &= enum_refl_find_by_label(eds[0], "E100") == 2 && !strcmp(enum_refl_label_of(eds[99], E3, "?"), "E3") ;
+    ok &= !strcmp(enum_refl_label_of(big, 897, "?"), "TENANT_SCHEMA_FIELD_299") ;
+    size_t used, reserved ;
+    enum_desc_arena_usage(arena, &used, &reserved) ;
+    ok &= used > 0 && used <= reserved ;
+    printf("arena: trie_labels=%d %s\n", !!(big->flags & ENUM_DESC_F_TRIE_LABELS), ok ? "PASS" : "FAIL") ;
+    enum_desc_arena_release(arena) ;
+}
+
+static void test_label_sets(enum_desc_arena_t arena)
+{
+    static const char *const wire[] = { "ok", "created", "accepted", "no_content", "moved", "found", "not_modified", "bad_request", "not_found", "ok" } ;
+    static const char *const display[] = { "OK", "Created", "Accepted", "No Content", "Moved Permanently", "Found", "Not Modified", "Bad Request", "Not Found", "Fine" } ;
+    const struct enum_desc_label_set_def sets[] = { { "wire", wire }, { "display", display } } ;
+    enum_desc_t ed = enum_refl_build_sets(arena, "http_status", (struct enum_desc_entry []) {
+        { 200, "HTTP_OK" }, { 201, "HTTP_CREATED" }, { 202, "HTTP_ACCEPTED" }, { 204, "HTTP_NO_CONTENT" }, { 301, "HTTP_MOVED" },
+        { 302, "HTTP_FOUND" }, { 304, "HTTP_NOT_MODIFIED" }, { 400, "HTTP_BAD_REQUEST" }, { 404, "HTTP_NOT_FOUND" }, { 200, "HTTP_FINE" }, {} }, NULL, sets, 2) ;
+    int wire_set = enum_desc_label_set_find(ed, "wire"), disp_set = enum_desc_label_set_find(ed, "display") ;
+    int ok = enum_desc_label_set_count(ed) == 2 && wire_set == 1 && disp_set == 2 && enum_desc_label_set_find(ed, "nope") == -1 ;
+    ok &= ed->label_sets[0].trie != NULL && enum_desc_label_set_name(ed, 0) == NULL && !strcmp(enum_desc_label_set_name(ed, 2), "display") ;
+    for (int i=0 ; i<10 ; i++) {
+        ok &= !strcmp(enum_desc_label_at_set(ed, wire_set, i), wire[i]) && !strcmp(enum_desc_label_at_set(ed, disp_set, i), display[i]) ;
+        ok &= enum_desc_label_at_set(ed, 0, i) == enum_desc_label_at(ed, i) ;
+        ok &= enum_desc_find_by_label_set(ed, disp_set, display[i]) == i ;
+        ok &= enum_desc_find_by_label_set(ed, wire_set, wire[i]) == (i == 9 ? 0 : i) ;   // "ok" twice: first wins
+    }
+    ok &= enum_desc_find_by_label_set(ed, wire_set, "HTTP_OK") == ENUM_DESC_NOT_FOUND && enum_desc_find_by_label_set(ed, 0, "HTTP_OK") == 0 ;
+    ok &= enum_desc_find_by_label_set(ed, 3, "ok") == ENUM_DESC_NOT_FOUND && enum_desc_label_at_set(ed, 3, 0) == NULL && enum_desc_label_at_set(ed, 1, 10) == NULL ;
+    printf("label sets(%s): %s=%s %s=%s %s\n", arena ? "arena" : "heap", enum_desc_label_set_name(ed, 1), enum_desc_label_at_set(ed, 1, 7),
+        enum_desc_label_set_name(ed, 2), enum_desc_label_at_set(ed, 2, 4), ok ? "PASS" : "FAIL") ;
+    enum_desc_destroy(ed) ;
+
+    // Too few items for a trie: scanned, a long probe must not read past the last label
+    static const char *const short_wire[] = { "on", "off" } ;
+    const struct enum_desc_label_set_def short_sets[] = { { "wire", short_wire } } ;
+    ed = enum_refl_build_sets(arena, "power", (struct enum_desc_entry []) { { 1, "POWER_ON" }, { 0, "POWER_OFF" }, {} }, NULL, short_sets, 1) ;
+    char probe[200] ;
+    memset(probe, 'o', sizeof(probe)-1) ;
+    probe[sizeof(probe)-1] = '\0' ;
+    ok = ed->label_sets[0].trie == NULL && enum_desc_find_by_label_set(ed, 1, "off") == 1 ;
+    ok &= enum_desc_find_by_label_set(ed, 1, probe) == ENUM_DESC_NOT_FOUND && enum_desc_find_by_label_set(ed, 1, "of") == ENUM_DESC_NOT_FOUND ;
+    printf("label sets(%s) scan: %s\n", arena ? "arena" : "heap", ok ? "PASS" : "FAIL") ;
+    enum_desc_destroy(ed) ;
+}
+
+// 26 items, 4 with meta: packed meta, plus a weight and a rate column.
+static void test_meta(enum_desc_arena_t arena)
+{
+    struct enum_desc_entry entries[27] = { 0 } ;
+    static char labels[26][4] ;
+    uint32_t weight[26] ;
+    double rate[26] ;
+    for (int i=0 ; i<26 ; i++) {
+        snprintf(labels[i], sizeof(labels[i]), "%c%c%c", 'A'+i, 'A'+i, 'A'+i) ;
+        entries[i] = (struct enum_desc_entry) { .value = 100 + 3*i, .name = labels[i] } ;
+        weight[i] = 10 * i ;
+        rate[i] = i / 4.0 ;
+    }
+    entries[0].meta = "First" ; entries[5].meta = "Fifth" ; entries[10].meta = "Tenth" ; entries[20].meta = "Twentieth" ;
+    const struct enum_desc_column_def cols[] = { { "weight", sizeof(uint32_t), weight }, { "rate", sizeof(double), rate } } ;
+    enum_desc_t ed = enum_refl_build_with(arena, "s26", entries, NULL, &(struct enum_refl_build_opts) { .columns = cols, .column_count = 2 }) ;
+    int w = enum_desc_column_find(ed, "weight"), r = enum_desc_column_find(ed, "rate") ;
+    size_t size = 0 ;
+    const double *rates = enum_desc_column_data(ed, r, &size) ;
+    int ok = ed->meta_info && ed->meta_info->bits && w == 0 && r == 1 && enum_desc_column_find(ed, "nope") == -1 && size == sizeof(double) ;
+    for (int i=0 ; i<26 ; i++) {
+        ok &= enum_desc_meta_at(ed, i) == entries[i].meta && enum_refl_meta_of(ed, 100 + 3*i) == entries[i].meta ;
+        ok &= enum_desc_inline_meta_at(ed, i) == entries[i].meta ;
+        ok &= *(const uint32_t *) enum_refl_column_of(ed, w, 100 + 3*i) == weight[i] && rates[i] == rate[i] ;
+    }
+    ok &= enum_refl_meta_of(ed, 101) == NULL && enum_refl_column_of(ed, w, 101) == NULL && enum_desc_column_at(ed, 2, 0) == NULL ;
+    ok &= enum_desc_column_at(ed, w, 26) == NULL && enum_desc_meta_at(ed, 26) == NULL ;
+    printf("meta(%s): %s %s weight=%u rate=%g %s\n", arena ? "arena" : "heap", (char *) enum_refl_meta_of(ed, 130),
+        (char *) enum_refl_meta_of(ed, 160), *(const uint32_t *) enum_refl_column_of(ed, w, 121), rates[7], ok ? "PASS" : "FAIL") ;
+    enum_desc_destroy(ed) ;
+}
+
+static void print_order(const char *title, enum_desc_t ed, enum enum_desc_order order)
+{
+    struct enum_desc_iter it ;
+    printf("%s:", title) ;
+    enum_desc_iter_sorted(ed, order, &it) ;
+    for (enum_desc_idx i ; (i = enum_desc_iter_next(&it)) != ENUM_DESC_NOT_FOUND ; )
+        printf(" %s=%d", enum_desc_label_at(ed, i), enum_desc_value_at(ed, i)) ;
+    printf("\n") ;
+}
+
+// Same sequences with and without the indexes (scan fallback).
+static int same_order(enum_desc_t a, enum_desc_t b, enum enum_desc_order order)
+{
+    struct enum_desc_iter ia, ib ;
+    enum_desc_iter_sorted(a, order, &ia) ;
+    enum_desc_iter_sorted(b, order, &ib) ;
+    for (;;) {
+        enum_desc_idx x = enum_desc_iter_next(&ia), y = enum_desc_iter_next(&ib) ;
+        if ( x != y ) return 0 ;
+        if ( x == ENUM_DESC_NOT_FOUND ) return 1 ;
+    }
+}
+
+static void test_order(void)
+{
+    enum_desc_t ed = enum_refl_build("currency", (struct enum_desc_entry []) {
+        { USD, "USD" }, { EUR, "EUR" }, { JPY, "JPY" }, { GBP, "GBP" }, { AUD, "AUD" }, { 826, "GBP" }, {} }, NULL) ;
+    print_order("by value", ed, ENUM_DESC_ORDER_VALUE) ;
+    print_order("by label", ed, ENUM_DESC_ORDER_LABEL) ;
+    enum_desc_idx idx[8] ;
+    int n = enum_desc_range(ed, 800, 900, idx, 2) ;
+    printf("range(800,900)=%d: %s %s\n", n, enum_desc_label_at(ed, idx[0]), enum_desc_label_at(ed, idx[1])) ;
+    struct enum_desc bare = *ed ;
+    bare.by_value = bare.by_label = bare.alias_next = NULL ;
+    bare.uniq_count = 0 ;
+    int ok = n == 4 && enum_desc_range(ed, 37, 825, idx, 8) == 0 && enum_desc_range(ed, 900, 800, idx, 8) == 0 ;
+    ok &= enum_desc_range(ed, 0, 36, idx, 8) == 1 && idx[0] == 4 && enum_desc_range(ed, 979, 2000, idx, 8) == 0 ;
+    ok &= enum_desc_range(&bare, 800, 900, idx, 8) == 4 && idx[0] == 2 && idx[1] == 3 && idx[2] == 5 && idx[3] == 0 ;
+    for (int o=ENUM_DESC_ORDER_DECL ; o<=ENUM_DESC_ORDER_LABEL ; o++) ok &= same_order(ed, &bare, o) ;
+    printf("order: %s\n", ok ? "PASS" : "FAIL") ;
+    enum_desc_destroy(ed) ;
+    print_order("static by value", &s2_desc, ENUM_DESC_ORDER_VALUE) ;
+}
+
+static void *intern_worker(void *arg)
+{
+    int *ok = arg ;
+    for (int i=0 ; i<2000 ; i++) {
+        enum_desc_t ed = enum_refl_build_interned(i & 1 ? "odd" : "even", (struct enum_desc_entry []) {
+            { 1, "ONE" }, { 2, i & 1 ? "TWO" : "DEUX" }, {} }, NULL) ;
+        if ( strcmp(enum_desc_label_at(ed, 1), i & 1 ? "TWO" : "DEUX") ) *ok = 0 ;
+        enum_desc_destroy(ed) ;
+    }
+    return NULL ;
+}
+
+// ext->destroy runs once per interned descriptor freed, never for a duplicate that lost the insert race.
+static atomic_int intern_ext_destroys ;
+static void intern_ext_destroy(enum_desc_t ed)
+{
+    atomic_fetch_add(&intern_ext_destroys, 1) ;
+}
+static const struct enum_desc_ext intern_ext = { .destroy = intern_ext_destroy } ;
+
+static void *intern_ext_worker(void *arg)
+{
+    for (int i=0 ; i<2000 ; i++) {
+        enum_desc_t ed = enum_refl_build_interned("shared", (struct enum_desc_entry []) { { 1, "ONE" }, { 2, "TWO" }, {} }, &intern_ext) ;
+        if ( ed->ext != &intern_ext ) *(int *) arg = 0 ;
+        enum_desc_destroy(ed) ;
+    }
+    return NULL ;
+}
+
+static void test_intern(void)
+{
+    struct enum_desc_entry entries[] = { { USD, "USD" }, { EUR, "EUR" }, { JPY, "JPY" }, {} } ;
+    enum_desc_t a = enum_refl_build_interned("currency", entries, NULL) ;
+    enum_desc_t b = enum_refl_build_interned("currency", entries, NULL) ;
+    entries[1].meta = "euro" ;
+    enum_desc_t c = enum_refl_build_interned("currency", entries, NULL) ;
+    size_t live, hits ;
+    enum_refl_intern_stats(&live, &hits) ;
+    int ok = a == b && c != a && live == 2 && hits == 1 ;
+    enum_desc_destroy(a) ;
+    ok &= !strcmp(enum_desc_label_at(b, 2), "JPY") && enum_refl_build_interned("currency", entries, NULL) == c ;
+    enum_desc_destroy(b) ;
+    enum_desc_destroy(c) ;
+    enum_desc_destroy(c) ;
+    enum_refl_intern_stats(&live, NULL) ;
+    ok &= live == 0 ;
+
+    pthread_t tids[4] ;
+    for (int t=0 ; t<4 ; t++) pthread_create(&tids[t], NULL, intern_worker, &ok) ;
+    for (int t=0 ; t<4 ; t++) pthread_join(tids[t], NULL) ;
+    size_t hits_before ;
+    enum_refl_intern_stats(NULL, &hits_before) ;
+    for (int t=0 ; t<4 ; t++) pthread_create(&tids[t], NULL, intern_ext_worker, &ok) ;
+    for (int t=0 ; t<4 ; t++) pthread_join(tids[t], NULL) ;
+    enum_refl_intern_stats(&live, &hits) ;
+    // Every build that was not a hit inserted a descriptor, freed once
+    ok &= (size_t) atomic_load(&intern_ext_destroys) == 4*2000 - (hits - hits_before) ;
+    printf("intern: live=%zu %s\n", live, ok ? "PASS" : "FAIL") ;
+}
+
+static void test_fingerprint(void)
+{
+    struct enum_desc_entry entries[] = { { USD, "USD" }, { EUR, "EUR" }, { JPY, "JPY" }, { GBP, "GBP" }, { AUD, "AUD" }, {} } ;
+    enum_desc_t a = enum_refl_build("currency", entries, NULL) ;
+    printf("fingerprint(currency)=%016llx\n", (unsigned long long) enum_desc_fingerprint(a)) ;
+    // Stored by the builder, computed for static descriptors without one
+    struct enum_desc_entry s2_entries[5] = { 0 } ;
+    for (int i=0 ; i<4 ; i++) s2_entries[i] = (struct enum_desc_entry) { enum_desc_value_at(&s2_desc, i), enum_desc_label_at(&s2_desc, i) } ;
+    enum_desc_t s2 = enum_refl_build("s2", s2_entries, NULL) ;
+    int ok = s2_desc.fingerprint == 0 && enum_desc_fingerprint(&s2_desc) == s2->fingerprint ;
+    ok &= enum_desc_diff(&s2_desc, s2, NULL) == 0 && enum_desc_diff(a, s2, NULL) > 0 ;
+    enum_desc_destroy(s2) ;
+
+    struct enum_desc_entry changed[] = { { USD, "USD" }, { JPY, "JPY" }, { EUR, "EUR" }, { 827, "GBP" }, { 124, "CAD" }, {} } ;
+    enum_desc_t b = enum_refl_build("currency", changed, NULL) ;
+    struct enum_desc_diff d ;
+    int n = enum_desc_diff(a, b, &d) ;
+    printf("diff: %d name=%d only_a=%d only_b=%d value_changed=%d moved=%d\n", n, d.name, d.only_a, d.only_b, d.value_changed, d.moved) ;
+    enum_desc_diff_print(stdout, a, b) ;
+    enum_desc_destroy(b) ;
+
+    // Trie-only labels hash the same as the entries
+    enum_desc_t f = build_fields(NULL) ;
+    struct enum_desc copy = *f ;
+    copy.fingerprint = 0 ;
+    ok &= enum_desc_fingerprint(&copy) == enum_desc_fingerprint(f) && enum_desc_diff(&copy, f, NULL) == 0 ;
+    enum_desc_destroy(f) ;
+    enum_desc_destroy(a) ;
+    printf("fingerprint: %s\n", ok ? "PASS" : "FAIL") ;
+}
+
+// Inline kernels agree with the library over values around the range and every label.
+static int check_inline(enum_desc_t ed)
+{
+    int ok = enum_desc_inline_value_count(ed) == enum_desc_value_count(ed) && enum_desc_inline_name(ed) == enum_desc_name(ed) ;
+    int n = enum_desc_value_count(ed) ;
+    for (int i=-1 ; i<=n ; i++) {
+        ok &= enum_desc_inline_value_at(ed, i) == enum_desc_value_at(ed, i) ;
+        ok &= enum_desc_inline_label_at(ed, i) == enum_desc_label_at(ed, i) ;
+        ok &= enum_desc_inline_meta_at(ed, i) == enum_desc_meta_at(ed, i) ;
+        if ( i >= 0 && i < n ) ok &= enum_desc_inline_find_by_label(ed, enum_desc_label_at(ed, i)) == enum_desc_find_by_label(ed, enum_desc_label_at(ed, i)) ;
+    }
+    ok &= enum_desc_inline_find_by_label(ed, "no such label") == ENUM_DESC_NOT_FOUND ;
+    for (int i=0 ; i<n ; i++) {
+        for (enum_desc_val v = enum_desc_value_at(ed, i) - 2 ; v <= enum_desc_value_at(ed, i) + 2 ; v++) {
+            ok &= enum_desc_inline_find_by_value(ed, v) == enum_desc_find_by_value(ed, v) ;
+            ok &= enum_desc_inline_is_valid(ed, v) == enum_desc_is_valid(ed, v) ;
+        }
+    }
+    return ok ;
+}
+
+static void test_inline(void)
+{
+    int ok = check_inline(&s2_desc) ;
+    enum_desc_t ed = enum_refl_build("aliases", (struct enum_desc_entry []) {
+        { 5, "A", "meta" }, { 7, "B" }, { 5, "C" }, { -100000, "D" }, { 100000, "E" }, {} }, NULL) ;
+    ok &= check_inline(ed) ;
+    enum_desc_destroy(ed) ;
+    ed = build_fields(NULL) ;
+    ok &= check_inline(ed) ;
+    enum_desc_destroy(ed) ;
+    printf("inline kernels: %s\n", ok ? "PASS" : "FAIL") ;
+}
+
 int main(int argc, char **argv)
 {
     test_static_desc(&s2_desc) ;
     test_dynamic_refl() ;
+    test_dynamic_valid() ;
+    test_aliases() ;
+    test_label_ptr(&s2_desc) ;
+    {
+        enum_desc_t e1_desc = enum_refl_build("e1", (struct enum_desc_entry []) { { E1, "E1"}, { E3, "E3" }, { E100, "E100"}, {} }, NULL) ;
+        test_label_ptr(e1_desc) ;
+        enum_desc_destroy(e1_desc) ;
+    }
+    test_cache() ;
+    test_trie() ;
+    test_matcher() ;
+    test_arena() ;
+    test_label_sets(NULL) ;
+    {
+        enum_desc_arena_t arena = enum_desc_arena_create(0) ;
+        test_label_sets(arena) ;
+        enum_desc_arena_release(arena) ;
+    }
+    test_inline() ;
+    test_meta(NULL) ;
+    test_order() ;
+    test_intern() ;
+    test_fingerprint() ;
+    {
+        enum_desc_arena_t arena = enum_desc_arena_create(0) ;
+        test_meta(arena) ;
+        enum_desc_arena_release(arena) ;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include <stdio.h>
+
+#include "enum_refl.h"
+#include "enum_desc_remap.h"
+
+enum color_v1 { RED=1, GREEN=2, BLUE=3, CYAN=4, BLACK=5, GRAY=6 } ;
+
+static void apply(enum_desc_remap_t map, const char *what)
+{
+    enum_desc_val vals[1003], expect[1003] ;
+    for (int i=0 ; i<1003 ; i++) {
+        vals[i] = i % 10 ;                  // 0, 7, 8, 9 are not in the old enum
+        expect[i] = enum_desc_remap_value(map, vals[i]) ;
+    }
+    size_t unknown = enum_desc_remap_apply(map, vals, 1003) ;
+    int ok = !memcmp(vals, expect, sizeof(vals)) ;
+    printf("apply(%s): 1..6 -> %d %d %d %d %d %d, 9 -> %d, unknown=%d %s\n", what,
+        vals[1], vals[2], vals[3], vals[4], vals[5], vals[6], vals[9], (int) unknown, ok ? "PASS" : "FAIL") ;
+}
+
+int main(int argc, char **argv)
+{
+    enum_desc_t v1 = enum_refl_build("color", (struct enum_desc_entry []) {
+        { RED, "RED" }, { GREEN, "GREEN" }, { BLUE, "BLUE" }, { CYAN, "CYAN" }, { BLACK, "BLACK" }, { GRAY, "GRAY" }, {} }, NULL) ;
+    // Renumbered, CYAN renamed to AZURE, BLACK dropped, GRAY renamed to GREY keeping its value, WHITE added
+    enum_desc_t v2 = enum_refl_build("color", (struct enum_desc_entry []) {
+        { 10, "RED" }, { 20, "GREEN" }, { 30, "BLUE" }, { 40, "AZURE" }, { 6, "GREY" }, { 50, "WHITE" }, {} }, NULL) ;
+
+    static const char *const renames[] = { "CYAN", "AZURE", NULL } ;
+    struct enum_desc_remap_policy keep = { .renames = renames } ;
+    enum_desc_remap_t map = enum_desc_remap_build(v1, v2, &keep) ;
+    enum_desc_remap_print(stdout, map) ;
+    apply(map, "keep") ;
+    enum_desc_remap_destroy(map) ;
+
+    struct enum_desc_remap_policy dflt = { .flags = ENUM_DESC_REMAP_DEFAULT | ENUM_DESC_REMAP_BY_VALUE, .default_value = -1, .renames = renames } ;
+    map = enum_desc_remap_build(v1, v2, &dflt) ;
+    enum_desc_remap_print(stdout, map) ;
+    apply(map, "default") ;
+    enum_desc_remap_destroy(map) ;
+
+    // Wide value spread: sorted table
+    enum_desc_t w1 = enum_refl_build("wide", (struct enum_desc_entry []) { { 1, "A" }, { 100000, "B" }, { -5000000, "C" }, {} }, NULL) ;
+    enum_desc_t w2 = enum_refl_build("wide", (struct enum_desc_entry []) { { 2, "A" }, { 3, "B" }, { 4, "C" }, {} }, NULL) ;
+    map = enum_desc_remap_build(w1, w2, NULL) ;
+    enum_desc_remap_print(stdout, map) ;
+    enum_desc_val vals[] = { 1, 100000, -5000000, 7 } ;
+    size_t unknown = enum_desc_remap_apply(map, vals, 4) ;
+    printf("apply(wide): %d %d %d %d unknown=%d\n", vals[0], vals[1], vals[2], vals[3], (int) unknown) ;
+    enum_desc_remap_destroy(map) ;
+
+    enum_desc_destroy(w2) ;
+    enum_desc_destroy(w1) ;
+    enum_desc_destroy(v2) ;
+    enum_desc_destroy(v1) ;
+    return 0 ;
+}
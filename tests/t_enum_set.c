@@ -0,0 +1,121 @@
+#include <stdio.h>
+
+#include "enum_refl.h"
+#include "enum_desc_set.h"
+
+enum s1 { AAA=100, BBB, CCC, DDD, EEE, FFF=200, GGG, HHH, III, JJJ, KKK=300, LLL, MMM, NNN, OOO, PPP=400, QQQ, RRR, SSS, TTT, UUU=500, VVV, WWW, XXX, YYY, ZZZ} ;
+enum currency { USD=840, EUR=978, JPY=826, GBP=826, AUD=36 } ;
+
+#define BIG 700
+
+static void show(const char *what, enum_desc_set_t s)
+{
+    char buf[256] ;
+    size_t len = enum_desc_set_format(s, ',', buf, sizeof(buf)) ;
+    printf("%s: count=%d len=%zu {%s}\n", what, enum_desc_set_count(s), len, buf) ;
+}
+
+// Set algebra on more than one 256 bit block, checked against plain bool arrays.
+static void test_big(void)
+{
+    static struct enum_desc_entry entries[BIG+1] ;
+    static char names[BIG][8] ;
+    for (int i=0 ; i<BIG ; i++) {
+        snprintf(names[i], sizeof(names[i]), "V%d", i) ;
+        entries[i] = (struct enum_desc_entry) { i * 3, names[i] } ;
+    }
+    enum_desc_t ed = enum_refl_build("big", entries, NULL) ;
+    enum_desc_set_t a = enum_desc_set_create(ed), b = enum_desc_set_create(ed), r = enum_desc_set_create(ed) ;
+    bool in_a[BIG], in_b[BIG] ;
+    for (int i=0 ; i<BIG ; i++) {
+        in_a[i] = i % 3 == 0 || i == BIG-1 ;
+        in_b[i] = i % 5 == 0 ;
+        if ( in_a[i] ) enum_desc_set_add(a, i * 3) ;
+        if ( in_b[i] ) enum_desc_set_add(b, i * 3) ;
+    }
+    int bad = 0 ;
+    for (int op=0 ; op<3 ; op++) {
+        int expect = 0 ;
+        if ( op == 0 ) enum_desc_set_union(r, a, b) ;
+        if ( op == 1 ) enum_desc_set_intersect(r, a, b) ;
+        if ( op == 2 ) enum_desc_set_difference(r, a, b) ;
+        for (int i=0 ; i<BIG ; i++) {
+            bool want = op == 0 ? in_a[i] || in_b[i] : op == 1 ? in_a[i] && in_b[i] : in_a[i] && !in_b[i] ;
+            expect += want ;
+            bad += enum_desc_set_contains(r, i * 3) != want ;
+        }
+        bad += enum_desc_set_count(r) != expect ;
+    }
+    int n = 0, last = -1 ;
+    ENUM_DESC_SET_FOREACH(a, idx) {
+        bad += idx <= last || !in_a[idx] ;
+        last = idx ;
+        n++ ;
+    }
+    enum_desc_set_fill(r) ;
+    bad += n != enum_desc_set_count(a) || last != BIG-1 || enum_desc_set_count(r) != BIG || !enum_desc_set_subset(a, r) ;
+    printf("big: items=%d count(a)=%d mismatches=%d\n", BIG, n, bad) ;
+    enum_desc_set_destroy(a) ;
+    enum_desc_set_destroy(b) ;
+    enum_desc_set_destroy(r) ;
+    enum_desc_destroy(ed) ;
+}
+
+int main(int argc, char **argv)
+{
+    enum_desc_t ed = enum_refl_build("s1", (struct enum_desc_entry []) {
+        { AAA, "AAA" }, { BBB, "BBB" }, { CCC, "CCC" }, { DDD, "DDD" }, { EEE, "EEE" }, { FFF, "FFF" }, { GGG, "GGG" },
+        { HHH, "HHH" }, { III, "III" }, { JJJ, "JJJ" }, { KKK, "KKK" }, { LLL, "LLL" }, { MMM, "MMM" }, { NNN, "NNN" },
+        { OOO, "OOO" }, { PPP, "PPP" }, { QQQ, "QQQ" }, { RRR, "RRR" }, { SSS, "SSS" }, { TTT, "TTT" }, { UUU, "UUU" },
+        { VVV, "VVV" }, { WWW, "WWW" }, { XXX, "XXX" }, { YYY, "YYY" }, { ZZZ, "ZZZ" }, {} }, NULL) ;
+
+    enum_desc_set_t vowels = enum_desc_set_create(ed), early = enum_desc_set_create(ed), r = enum_desc_set_create(ed) ;
+    size_t unknown = enum_desc_set_parse(vowels, ',', "AAA,EEE,III,,OOO,UUU,XYZ", (size_t) -1) ;
+    printf("parse: unknown=%zu\n", unknown) ;
+    for (enum_desc_val v=AAA ; v<=EEE ; v++) enum_desc_set_add(early, v) ;
+    printf("add 999: %d, contains III: %d, contains BBB: %d\n", enum_desc_set_add(early, 999),
+        enum_desc_set_contains(vowels, III), enum_desc_set_contains(vowels, BBB)) ;
+    show("vowels", vowels) ;
+    show("early", early) ;
+    enum_desc_set_union(r, vowels, early) ;
+    show("union", r) ;
+    enum_desc_set_intersect(r, vowels, early) ;
+    show("intersect", r) ;
+    enum_desc_set_difference(r, vowels, early) ;
+    show("difference", r) ;
+    enum_desc_set_remove(r, OOO) ;
+    show("remove OOO", r) ;
+    enum_desc_set_fill(r) ;
+    enum_desc_set_difference(r, r, vowels) ;
+    printf("consonants: %d, subset of vowels: %d\n", enum_desc_set_count(r), enum_desc_set_subset(r, vowels)) ;
+    char small[8] ;
+    size_t len = enum_desc_set_format(vowels, '|', small, sizeof(small)) ;
+    printf("truncated: len=%zu \"%s\"\n", len, small) ;
+
+    // Round trip through text
+    char buf[256] ;
+    enum_desc_set_format(vowels, ',', buf, sizeof(buf)) ;
+    enum_desc_set_clear(r) ;
+    enum_desc_set_parse(r, ',', buf, strlen(buf)) ;
+    printf("round trip equal: %d\n", enum_desc_set_equal(r, vowels)) ;
+
+    // Aliases are one member: GBP shares JPY's value
+    enum_desc_t cur = enum_refl_build("currency", (struct enum_desc_entry []) {
+        { USD, "USD" }, { EUR, "EUR" }, { JPY, "JPY" }, { GBP, "GBP" }, { AUD, "AUD" }, {} }, NULL) ;
+    enum_desc_set_t cs = enum_desc_set_create(cur) ;
+    enum_desc_set_add(cs, GBP) ;
+    enum_desc_set_parse(cs, ' ', "GBP AUD", 7) ;
+    show("currency", cs) ;
+    enum_desc_set_remove(cs, JPY) ;
+    show("remove JPY", cs) ;
+    printf("mixed descriptors: %d\n", enum_desc_set_union(r, r, cs)) ;
+    enum_desc_set_destroy(cs) ;
+    enum_desc_destroy(cur) ;
+
+    enum_desc_set_destroy(vowels) ;
+    enum_desc_set_destroy(early) ;
+    enum_desc_set_destroy(r) ;
+    enum_desc_destroy(ed) ;
+    test_big() ;
+    return 0 ;
+}
@@ -1,5 +1,6 @@
 // t_gcc.c
 #include <stdio.h>
+#include <stddef.h>
 #include "enum_desc_def.h"
 #include "enum_desc.h"
 
@@ -13,9 +14,23 @@ static enum_desc_t enum_desc_gen(enum currency x)
 
 enum_desc_t currency_desc(void) { return enum_desc_gen((enum currency) 0); }
 
+// No wrapper: the plugin emits a public __enum_desc__priority
+enum ENUM_REFLECT priority { PRIO_LOW=1, PRIO_HIGH=9 } ;
+ENUM_DESC_EXTERN(priority) ;
+static const enum_desc_t public_descs[] = { ENUM_DESC_REF(priority) } ;
+
 int main(int argc, char **argv)
 {
     enum_desc_t foo = currency_desc() ;
     enum_desc_print(stdout, foo, 1) ;
+    // Plugin packs header, values, offsets and labels into one aligned object
+    const char *base = (const char *) foo ;
+    printf("layout: aligned=%d values=%d lbl_off=%d strs=%d\n", (int) ((uintptr_t) base % 64 == 0),
+        (int) ((const char *) foo->values - base), (int) ((const char *) foo->lbl_off - base), (int) (foo->strs - base)) ;
+    // Fields a value lookup or label_at reads end at the first cache line
+    printf("header: size=%d lookup_end=%d\n", (int) sizeof(struct enum_desc), (int) (offsetof(struct enum_desc, by_value) + sizeof(foo->by_value))) ;
+    // Built with label-set=wire:lower
+    printf("set %s: %s %d\n", enum_desc_label_set_name(foo, 1), enum_desc_label_at_set(foo, 1, 2), enum_desc_find_by_label_set(foo, 1, "aud")) ;
+    enum_desc_print(stdout, public_descs[0], 1) ;
     return 0 ;
 }
@@ -1,21 +1,39 @@
-// t_gcc.c
+// t_gpp2.cc
 #include <stdio.h>
 #include "enum_desc_def.h"
 #include "enum_desc.h"
 
-enum currency { USD=840, EUR=978, JPY=826, GBP=826, AUD=36 } ;
+namespace pay {
+    enum class currency : short { USD=840, EUR=978, JPY=392 } ;
+    namespace v2 {
+        enum class currency : unsigned char { USD=1, EUR=2 } ;
+    }
+}
 
-static enum_desc_t enum_desc_gen(enum currency x)
+template <typename E> static enum_desc_t enum_desc_gen(E x)
 {
-    printf("stub: %s (%d)\n", __func__, x) ;
+    printf("stub: %s (%d)\n", __func__, (int) x) ;
     return NULL ;
 }
 
-enum_desc_t currency_desc(void) { return enum_desc_gen((enum currency) 0); }
+// Wrapper in a class template: rewritten per instantiation, never in the pattern
+template <typename T> struct box {
+    enum class state { EMPTY, FULL=10 } ;
+    static enum_desc_t desc() { return enum_desc_gen((state) 0) ; }
+} ;
+
+enum_desc_t currency_desc(void) { return enum_desc_gen((pay::currency) 0); }
+enum_desc_t currency_v2_desc(void) { return enum_desc_gen((pay::v2::currency) 0); }
+enum_desc_t box_int_state_desc(void) { return ENUM_DESC(box<int>::state); }
+enum_desc_t box_long_state_desc(void) { return ENUM_DESC(box<long>::state); }
 
 int main(int argc, char **argv)
 {
-    enum_desc_t foo = currency_desc() ;
-    enum_desc_print(stdout, foo, 1) ;
+    enum_desc_print(stdout, currency_desc(), 1) ;
+    enum_desc_print(stdout, currency_v2_desc(), 1) ;
+    enum_desc_print(stdout, box_int_state_desc(), 1) ;
+    enum_desc_print(stdout, box_long_state_desc(), 1) ;
+    enum_desc_t member = box<int>::desc() ;
+    printf("box<int>::desc: %s\n", member == box_int_state_desc() ? "same" : "differ") ;
     return 0 ;
 }